@@ -0,0 +1,296 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioAnalysis.h"
+
+using namespace aud;
+
+// loudness and the normalization gains derived from it round the same for any thread count or vector width
+UNC_DETERMINISTIC_FLOAT
+
+// measureLoudness - BS.1770 k-weighting
+IIRCoefficients makeKWeightingShelf( double sampleRate )
+{
+	const double gainDb = 3.999843853973347;
+	const double q = 0.7071752369554196;
+	const double freq = 1681.974450955533;
+
+	const auto a = std::pow( 10., gainDb / 40. );
+	const auto w0 = MathConstants<double>::twoPi * freq / sampleRate;
+	const auto alpha = std::sin( w0 ) / ( 2. * q );
+	const auto cosW0 = std::cos( w0 );
+	const auto sqrtA = std::sqrt( a );
+	return IIRCoefficients(
+		a * ( ( a + 1. ) + ( a - 1. ) * cosW0 + 2. * sqrtA * alpha ),
+		-2. * a * ( ( a - 1. ) + ( a + 1. ) * cosW0 ),
+		a * ( ( a + 1. ) + ( a - 1. ) * cosW0 - 2. * sqrtA * alpha ),
+		( a + 1. ) - ( a - 1. ) * cosW0 + 2. * sqrtA * alpha,
+		2. * ( ( a - 1. ) - ( a + 1. ) * cosW0 ),
+		( a + 1. ) - ( a - 1. ) * cosW0 - 2. * sqrtA * alpha );
+}
+
+IIRCoefficients makeKWeightingHighPass( double sampleRate )
+{
+	const double q = 0.5003270373238773;
+	const double freq = 38.13547087602444;
+
+	const auto w0 = MathConstants<double>::twoPi * freq / sampleRate;
+	const auto alpha = std::sin( w0 ) / ( 2. * q );
+	const auto cosW0 = std::cos( w0 );
+	return IIRCoefficients(
+		( 1. + cosW0 ) / 2.,
+		-( 1. + cosW0 ),
+		( 1. + cosW0 ) / 2.,
+		1. + alpha,
+		-2. * cosW0,
+		1. - alpha );
+}
+
+double energyToLufs( double meanSquare )
+{
+	return -0.691 + 10. * std::log10( meanSquare );
+}
+
+double measureIntegratedLoudness( const AudioBuffer<float>& buffer, double sampleRate )
+{
+	const auto numChans = buffer.getNumChannels();
+	const auto numSamps = buffer.getNumSamples();
+
+	// k-weighted energy of 100ms segments, summed over channels
+	const auto segmentLen = jmax( 1, roundToInt( sampleRate * 0.1 ) );
+	const auto numSegments = ( numSamps + segmentLen - 1 ) / segmentLen;
+	std::vector<double> segments( numSegments, 0. );
+	HeapBlock<float> scratch( segmentLen );
+	for( int ch = 0; ch < numChans; ++ch ){
+		IIRFilter shelf;
+		IIRFilter highPass;
+		shelf.setCoefficients( makeKWeightingShelf( sampleRate ) );
+		highPass.setCoefficients( makeKWeightingHighPass( sampleRate ) );
+		for( int seg = 0; seg < numSegments; ++seg ){
+			const auto start = seg * segmentLen;
+			const auto len = jmin( segmentLen, numSamps - start );
+			FloatVectorOperations::copy( scratch, buffer.getReadPointer( ch, start ), len );
+			shelf.processSamples( scratch, len );
+			highPass.processSamples( scratch, len );
+			double sum = 0.;
+			for( int i = 0; i < len; ++i ){
+				sum += scratch[ i ] * scratch[ i ];
+			}
+			segments[ seg ] += sum;
+		}
+	}
+	// 400ms gating blocks with 75% overlap, short buffers make one block
+	const int segmentsPerBlock = 4;
+	const auto numBlocks = jmax( 1, numSegments - segmentsPerBlock + 1 );
+	std::vector<double> blocks( numBlocks, 0. );
+	for( int block = 0; block < numBlocks; ++block ){
+		const auto end = jmin( block + segmentsPerBlock, numSegments );
+		for( int seg = block; seg < end; ++seg ){
+			blocks[ block ] += segments[ seg ];
+		}
+		const auto len = jmin( numSamps - block * segmentLen, segmentsPerBlock * segmentLen );
+		blocks[ block ] /= len;
+	}
+	// absolute gate at -70 LUFS, relative gate 10 LU below
+	auto gatedMean = [ & ]( double threshold ){
+		double sum = 0.;
+		int num = 0;
+		for( auto energy : blocks ){
+			if( energyToLufs( energy ) > threshold ){
+				sum += energy;
+				++num;
+			}
+		}
+		return num > 0 ? sum / num : 0.;
+	};
+	const auto absolute = gatedMean( Loudness::MinLoudness );
+	if( absolute <= 0. ){
+		return Loudness::MinLoudness;
+	}
+	const auto relative = gatedMean( energyToLufs( absolute ) - 10. );
+	if( relative <= 0. ){
+		return Loudness::MinLoudness;
+	}
+	return jmax( Loudness::MinLoudness, energyToLufs( relative ) );
+}
+
+// measureLoudness - true peak
+float measureTruePeak( const AudioBuffer<float>& buffer )
+{
+	const int oversampling = 4;
+	const int chunkLen = 1024;
+	HeapBlock<float> scratch( chunkLen * oversampling );
+	float ret = 0.f;
+	for( int ch = 0; ch < buffer.getNumChannels(); ++ch ){
+		LagrangeInterpolator interpolator;
+		auto* read = buffer.getReadPointer( ch );
+		auto remaining = buffer.getNumSamples();
+		while( remaining > 0 ){
+			const auto numOut = jmin( chunkLen, remaining ) * oversampling;
+			const auto numUsed = interpolator.process( 1. / oversampling, read, scratch, numOut, remaining, 0 );
+			const auto range = FloatVectorOperations::findMinAndMax( scratch, numOut );
+			ret = jmax( ret, -range.getStart(), range.getEnd() );
+			if( numUsed <= 0 ){
+				break;
+			}
+			read += numUsed;
+			remaining -= numUsed;
+		}
+	}
+	return ret;
+}
+
+Loudness aud::measureLoudness( const AudioBuffer<float>& buffer, double sampleRate )
+{
+	UNC_TRACE_SCOPE( "loudness" );
+	Loudness ret;
+	const auto numChans = buffer.getNumChannels();
+	const auto numSamps = buffer.getNumSamples();
+	if( numChans == 0 || numSamps == 0 || sampleRate <= 0. ){
+		return ret;
+	}
+	// peak and rms
+	double meanSquare = 0.;
+	for( int ch = 0; ch < numChans; ++ch ){
+		ret.peak = jmax( ret.peak, buffer.getMagnitude( ch, 0, numSamps ) );
+		const double rms = buffer.getRMSLevel( ch, 0, numSamps );
+		meanSquare += rms * rms;
+	}
+	ret.rms = ( float )std::sqrt( meanSquare / numChans );
+	if( ret.isSilent() ){
+		return ret;
+	}
+	// loudness
+	ret.truePeak = jmax( ret.peak, measureTruePeak( buffer ) );
+	ret.integrated = measureIntegratedLoudness( buffer, sampleRate );
+	return ret;
+}
+
+// getNormalizationGain
+float aud::getNormalizationGain( const aud::Loudness& loudness, const Normalization& normalization )
+{
+	if( loudness.isSilent() ){
+		return 1.f;
+	}
+	switch( normalization.mode ){
+		case Normalization::Peak:{
+			return Decibels::decibelsToGain( normalization.peakTarget ) / loudness.peak;
+		}
+		case Normalization::Integrated:{
+			// never push the true peak over the ceiling
+			auto gain = Decibels::decibelsToGain( normalization.loudnessTarget - ( float )loudness.integrated );
+			auto limit = Decibels::decibelsToGain( normalization.truePeakCeiling ) / loudness.truePeak;
+			return jmin( gain, limit );
+		}
+		default:{
+			return 1.f;
+		}
+	}
+}
+
+// findAudibleRange
+/// \returns highest magnitude over all channels.
+float getMaxMagnitude( const AudioBuffer<float>& buffer, int start, int length )
+{
+	float ret = 0.f;
+	for( int ch = 0; ch < buffer.getNumChannels(); ++ch ){
+		ret = jmax( ret, buffer.getMagnitude( ch, start, length ) );
+	}
+	return ret;
+}
+
+/// \returns true if any channel exceeds threshold at pos.
+bool exceedsThreshold( const AudioBuffer<float>& buffer, int pos, float threshold )
+{
+	for( int ch = 0; ch < buffer.getNumChannels(); ++ch ){
+		if( std::abs( buffer.getSample( ch, pos ) ) > threshold ){
+			return true;
+		}
+	}
+	return false;
+}
+
+float aud::estimateNoiseFloor( const AudioBuffer<float>& buffer )
+{
+	// envelope windows, peak per window
+	const auto numWindows = buffer.getNumSamples() / EnvelopeWindow;
+	if( numWindows == 0 ){
+		return 0.f;
+	}
+	std::vector<float> envelope( numWindows );
+	for( int w = 0; w < numWindows; ++w ){
+		envelope[ w ] = getMaxMagnitude( buffer, w * EnvelopeWindow, EnvelopeWindow );
+	}
+	// the 10th percentile is robust against single dropouts of digital silence
+	auto percentile = envelope.begin() + numWindows / 10;
+	std::nth_element( envelope.begin(), percentile, envelope.end() );
+	return *percentile;
+}
+
+Range<int> aud::findAudibleRange( const AudioBuffer<float>& buffer, Range<int> range, float noiseFloor, float thresholdDb )
+{
+	range = range.getIntersectionWith( { 0, buffer.getNumSamples() } );
+	const auto threshold = jmax( noiseFloor * Decibels::decibelsToGain( thresholdDb ), Decibels::decibelsToGain( -90.f ) );
+
+	// coarse scan per window, then find the exact sample inside the window
+	auto start = range.getEnd();
+	for( auto pos = range.getStart(); pos < range.getEnd(); pos += EnvelopeWindow ){
+		const auto len = jmin( EnvelopeWindow, range.getEnd() - pos );
+		if( getMaxMagnitude( buffer, pos, len ) > threshold ){
+			start = pos;
+			while( !exceedsThreshold( buffer, start, threshold ) ){
+				++start;
+			}
+			break;
+		}
+	}
+	if( start == range.getEnd() ){
+		return { range.getStart(), range.getStart() };
+	}
+	auto end = start;
+	for( auto pos = range.getEnd(); pos > start; pos -= EnvelopeWindow ){
+		const auto len = jmin( EnvelopeWindow, pos - start );
+		if( getMaxMagnitude( buffer, pos - len, len ) > threshold ){
+			end = pos;
+			while( !exceedsThreshold( buffer, end - 1, threshold ) ){
+				--end;
+			}
+			break;
+		}
+	}
+	return { start, end };
+}
+
+// parallelFor
+/// Progress of one parallelFor, outlives it for helpers that start after all items are taken.
+struct ParallelItems
+{
+	std::atomic<int> nextItem{ 0 };
+	std::atomic<int> numDone{ 0 };
+	WaitableEvent allDone;
+};
+
+void aud::parallelFor( int numItems, const std::function<void( int )>& func, unc::JobPriority priority )
+{
+	auto* scheduler = unc::getJobScheduler();
+	const auto numThreads = jmin( numItems, scheduler->getNumWorkers() + 1 );
+	if( numThreads <= 1 ){
+		for( int i = 0; i < numItems; ++i ){
+			func( i );
+		}
+		return;
+	}
+	// helpers and calling thread pull indices until all are taken, late helpers find none and never touch func
+	auto items = std::make_shared<ParallelItems>();
+	auto work = [ items, numItems, &func ](){
+		for( int i = items->nextItem++; i < numItems; i = items->nextItem++ ){
+			func( i );
+			if( ++items->numDone == numItems ){
+				items->allDone.signal();
+			}
+		}
+	};
+	for( int t = 1; t < numThreads; ++t ){
+		scheduler->add( work, priority );
+	}
+	work();
+	items->allDone.wait();
+}
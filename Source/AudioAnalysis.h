@@ -0,0 +1,68 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include "AudioFunctions.h"
+#include "JobScheduler.h"
+
+namespace aud
+{
+	/// Level measurements of an audio buffer, gains are linear.
+	struct Loudness
+	{
+		float peak = 0.f;
+		float truePeak = 0.f;
+		float rms = 0.f;
+
+		/// EBU R128 integrated loudness in LUFS.
+		double integrated = MinLoudness;
+
+		// access
+		bool isSilent() const{ return peak <= 0.f; }
+
+		static constexpr double MinLoudness = -70.;
+	};
+
+	/// Measures peak, rms, EBU R128 integrated loudness and 4x oversampled true peak.
+	Loudness measureLoudness( const AudioBuffer<float>& buffer, double sampleRate );
+
+	/// How rendered audio gets gain staged before writing.
+	struct Normalization
+	{
+		enum Mode
+		{
+			Off, Peak, Integrated
+		};
+		/// Files in a linked group share one gain, keeping their relative levels.
+		enum Link
+		{
+			PerFile, PerClip, PerBatch
+		};
+		Mode mode = Off;
+		Link link = PerFile;
+		float peakTarget = -1.f; // dBFS
+		float loudnessTarget = -23.f; // LUFS
+		float truePeakCeiling = -1.f; // dBTP, limits loudness gain
+
+		// access
+		bool isActive() const{ return mode != Off; }
+	};
+
+	/// \returns linear gain that brings measured audio to the normalization target.
+	float getNormalizationGain( const aud::Loudness& loudness, const Normalization& normalization );
+
+	/// Envelope resolution of the silence scanner.
+	const static int EnvelopeWindow( 64 );
+
+	/// \returns the level that most of the quietest envelope windows stay below, linear.
+	float estimateNoiseFloor( const AudioBuffer<float>& buffer );
+
+	/// Scans for the first and last sample louder than the noise floor plus thresholdDb.
+	/// \returns audible part of the range, empty if all of it is below threshold.
+	Range<int> findAudibleRange( const AudioBuffer<float>& buffer, Range<int> range, float noiseFloor, float thresholdDb = 12.f );
+
+	/// Calls func for every index from 0 to numItems on all cores, returns when all are done.
+	/// Runs as jobs of priority on the application scheduler, the calling thread takes part.
+	void parallelFor( int numItems, const std::function<void( int )>& func, unc::JobPriority priority = unc::JobPriority::Background );
+}
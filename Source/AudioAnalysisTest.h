@@ -0,0 +1,119 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "AudioAnalysis.h"
+
+namespace aud
+{
+	class AudioAnalysisTest : public UnitTest
+	{
+	public:
+		AudioAnalysisTest() : UnitTest( "AudioAnalysisTest" ){}
+
+		void runTest() override
+		{
+			testLoudness();
+			testNormalizationGain();
+			testAudibleRange();
+		}
+
+		/// Full scale sine, 997Hz, one second.
+		AudioBuffer<float> createSine( int numChans, double sampleRate, float gain )
+		{
+			AudioBuffer<float> ret( numChans, ( int )sampleRate );
+			for( int ch = 0; ch < numChans; ++ch ){
+				for( int i = 0; i < ret.getNumSamples(); ++i ){
+					ret.setSample( ch, i, gain * ( float )std::sin( MathConstants<double>::twoPi * 997. * i / sampleRate ) );
+				}
+			}
+			return ret;
+		}
+
+		void testLoudness()
+		{
+			beginTest( "testLoudness" );
+
+			// silence
+			AudioBuffer<float> silence( 2, 48000 );
+			silence.clear();
+			auto s = measureLoudness( silence, 48000. );
+			expect( s.isSilent() );
+			expectEquals( s.integrated, Loudness::MinLoudness );
+
+			// full scale sine in one channel reads -3.01 LUFS per BS.1770
+			auto sine = createSine( 1, 48000., 1.f );
+			auto l = measureLoudness( sine, 48000. );
+			expectWithinAbsoluteError( l.peak, 1.f, 0.001f );
+			expectWithinAbsoluteError( l.rms, 0.7071f, 0.001f );
+			expectWithinAbsoluteError( l.integrated, -3.01, 0.1 );
+			expectGreaterOrEqual( l.truePeak, l.peak );
+
+			// half gain is 6 LU quieter
+			auto half = createSine( 1, 48000., 0.5f );
+			expectWithinAbsoluteError( measureLoudness( half, 48000. ).integrated, -9.03, 0.1 );
+		}
+
+		void testNormalizationGain()
+		{
+			beginTest( "testNormalizationGain" );
+
+			Loudness l;
+			l.peak = 0.5f;
+			l.truePeak = 0.5f;
+			l.integrated = -20.;
+
+			// peak
+			Normalization n;
+			n.mode = Normalization::Peak;
+			n.peakTarget = 0.f;
+			expectWithinAbsoluteError( getNormalizationGain( l, n ), 2.f, 0.0001f );
+
+			// loudness
+			n.mode = Normalization::Integrated;
+			n.loudnessTarget = -26.f;
+			expectWithinAbsoluteError( getNormalizationGain( l, n ), Decibels::decibelsToGain( -6.f ), 0.0001f );
+
+			// loudness limited by true peak ceiling
+			n.loudnessTarget = -6.f;
+			n.truePeakCeiling = 0.f;
+			expectWithinAbsoluteError( getNormalizationGain( l, n ), 2.f, 0.0001f );
+
+			// off and silent
+			n.mode = Normalization::Off;
+			expectEquals( getNormalizationGain( l, n ), 1.f );
+			expectEquals( getNormalizationGain( Loudness(), n ), 1.f );
+		}
+
+		void testAudibleRange()
+		{
+			beginTest( "testAudibleRange" );
+
+			// low noise with a burst in the middle
+			AudioBuffer<float> b( 2, 1000 );
+			Random rnd( 1 );
+			for( int i = 0; i < b.getNumSamples(); ++i ){
+				b.setSample( 0, i, ( rnd.nextFloat() - 0.5f ) * 0.001f );
+				b.setSample( 1, i, 0.f );
+			}
+			for( int i = 301; i < 700; ++i ){
+				b.setSample( 1, i, 0.5f );
+			}
+			auto floor = estimateNoiseFloor( b );
+			expectLessThan( floor, 0.001f );
+
+			auto r = findAudibleRange( b, { 0, 1000 }, floor );
+			expectEquals( r.getStart(), 301 );
+			expectEquals( r.getEnd(), 700 );
+
+			// range is respected
+			r = findAudibleRange( b, { 400, 500 }, floor );
+			expectEquals( r.getStart(), 400 );
+			expectEquals( r.getEnd(), 500 );
+
+			// nothing audible
+			r = findAudibleRange( b, { 0, 300 }, floor );
+			expect( r.isEmpty() );
+		}
+	};
+	static AudioAnalysisTest audioAnalysisTest;
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "Benchmark.h"
+
+#include "AudioClip.h"
+#include "AudioPlayback.h"
+#include "AudioRender.h"
+
+namespace unc
+{
+	class AudioBenchmark : public Benchmark
+	{
+	public:
+		AudioBenchmark() : Benchmark( "AudioBenchmark" ){}
+
+		void run() override
+		{
+			benchmarkResampler();
+			benchmarkFades();
+			benchmarkWrite();
+			benchmarkDecode();
+			benchmarkRender();
+		}
+
+		/// Noise, so no processing can be skipped.
+		AudioBuffer<float> createNoise( int numChans, int numSamps )
+		{
+			AudioBuffer<float> ret( numChans, numSamps );
+			Random random( 1 );
+			for( int ch = 0; ch < numChans; ++ch ){
+				for( int i = 0; i < numSamps; ++i ){
+					ret.setSample( ch, i, random.nextFloat() * 2.f - 1.f );
+				}
+			}
+			return ret;
+		}
+
+		/// Plays the whole sample at ratio in device sized blocks.
+		/// \returns number of output samples.
+		int64 measureResampler( const String& caseName, int numChans, int length, double ratio, int fade )
+		{
+			auto source = createNoise( numChans, length );
+			aud::Resampler resampler( source );
+			resampler.setFadeIn( fade );
+			resampler.setFadeOut( fade );
+			resampler.setRatio( ratio );
+			AudioBuffer<float> block( numChans, 512 );
+			const auto numOut = ( int64 )( length / ratio );
+			measure( caseName, numOut, [ & ](){
+				resampler.reset( 0 );
+				for( int64 pos = 0; pos < numOut; pos += block.getNumSamples() ){
+					resampler.process( block );
+				}
+			} );
+			return numOut;
+		}
+
+		void benchmarkResampler()
+		{
+			// sweep one dimension at a time around stereo, 1 second, unity
+			for( auto length : { 4096, 44100, 441000 } ){
+				measureResampler( "resampler/length/" + String( length ), 2, length, 1., 0 );
+			}
+			for( auto ratio : { 0.5, 0.99, 1., 1.5, 2., 4. } ){
+				measureResampler( "resampler/ratio/" + String( ratio ), 2, 44100, ratio, 0 );
+			}
+			for( auto numChans : { 1, 2, 4, 8, 16 } ){
+				measureResampler( "resampler/channels/" + String( numChans ), numChans, 44100, 1.5, 0 );
+			}
+			for( auto fade : { 0, 64, 4096, 22050 } ){
+				measureResampler( "resampler/fade/" + String( fade ), 2, 44100, 1., fade );
+			}
+		}
+
+		void benchmarkFades()
+		{
+			for( auto fade : { 64, 4096, 44100 } ){
+				AudioBuffer<float> block( 2, 512 );
+				aud::FadeIn fadeIn( fade );
+				aud::FadeOut fadeOut( fade );
+				measure( "fadeIn/" + String( fade ), fade, [ & ](){
+					fadeIn.reset();
+					for( int pos = 0; pos < fade; pos += block.getNumSamples() ){
+						fadeIn.process( block, pos, 1. );
+					}
+				} );
+				measure( "fadeOut/" + String( fade ), fade, [ & ](){
+					fadeOut.reset();
+					for( int pos = 0; pos < fade; pos += block.getNumSamples() ){
+						fadeOut.process( block, pos, 1. );
+					}
+				} );
+			}
+		}
+
+		void benchmarkWrite()
+		{
+			auto source = createNoise( 2, 441000 );
+			for( auto length : { 4096, 44100, 441000 } ){
+				const auto fade = length / 8;
+				measure( "writePlay/" + String( length ), length, [ & ](){
+					std::unique_ptr<AudioBuffer<float>> out( writePlay( source, 0, length, fade, fade ) );
+				} );
+				measure( "writeLoop/" + String( length ), length, [ & ](){
+					std::unique_ptr<AudioBuffer<float>> out( writeLoop( source, 0, length, fade ) );
+				} );
+			}
+		}
+
+		/// \returns audio files of the fixtures folder.
+		Array<File> findFixtures() const
+		{
+			if( !fixtures.isDirectory() ){
+				return {};
+			}
+			return fixtures.findChildFiles( File::findFiles, false, getAudioFormatManager()->getWildcardForAllFormats() );
+		}
+
+		void benchmarkDecode()
+		{
+			for( const auto& file : findFixtures() ){
+				AudioSettings settings;
+				aud::createOrGetSamplesFor( file, settings );
+				measure( "decode/" + file.getFileName(), settings.bufferSize, [ & ](){
+					aud::decodeAudioFile( file, settings );
+				}, 5 );
+				measure( "decode/cached/" + file.getFileName(), settings.bufferSize, [ & ](){
+					aud::createOrGetSamplesFor( file, settings );
+				}, 5 );
+			}
+		}
+
+		void benchmarkRender()
+		{
+			// synthetic clip plus every fixture, split into zones
+			std::vector<AudioClip::Ptr> clips;
+			clips.push_back( createAudioClip( createNoise( 2, 441000 ), { 44100., 0, 24 }, "noise" ) );
+			for( const auto& file : findFixtures() ){
+				if( auto clip = createAudioClip( file ) ){
+					clips.push_back( clip );
+				}
+			}
+			const int numZones = 8;
+			RenderJobs jobs;
+			int64 numSamps = 0;
+			auto outDir = File::getSpecialLocation( File::tempDirectory ).getChildFile( "UnicycleBenchmark" );
+			for( auto& clip : clips ){
+				const auto length = clip->getTotalNumSamples() / numZones;
+				for( int z = 0; z < numZones; ++z ){
+					AudioPlayZone zone;
+					zone.start = z * length;
+					zone.length = length;
+					zone.fadeOut = length / 8;
+					zone.mode = z % 2 == 0 ? AudioPlayMode::Play : AudioPlayMode::Loop;
+					clip->addZone( zone );
+					jobs.push_back( { clip.get(), clip->sizeZones() - 1, outDir.getChildFile( clip->getName() + "_" + String( z ) + ".wav" ) } );
+					numSamps += length;
+				}
+			}
+			// a failed render is reported as such, never timed as a fast success
+			auto measureRender = [ & ]( const String& caseName, const RenderSettings& settings ){
+				auto res = Result::ok();
+				measure( caseName, numSamps, [ & ](){
+					auto run = unc::render( jobs, settings );
+					if( run.failed() ){
+						res = run;
+					}
+				}, 5 );
+				if( res.failed() ){
+					fail( caseName, res.getErrorMessage() );
+				}
+			};
+			RenderSettings settings;
+			measureRender( "render/wav24", settings );
+			settings.output.format = aud::FileFormat::Flac;
+			settings.output.bitsPerSample = 16;
+			settings.normalization.mode = aud::Normalization::Integrated;
+			measureRender( "render/flac16/normalized", settings );
+			outDir.deleteRecursively();
+		}
+	};
+	static AudioBenchmark audioBenchmark;
+}
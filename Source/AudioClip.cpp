@@ -50,13 +50,14 @@ void unc::AudioPlayZone::fromXml( XmlElement * xml )
 AudioBuffer<float>* unc::writePlay( const AudioBuffer<float>& source, int start, int length, int fadeIn, int fadeOut )
 {
 	jassert( fadeIn + fadeOut <= length );
+	UNC_TRACE_SCOPE( "play" );
 
 	// play from start to end
 	aud::Resampler play( source );
 	play.setRange( start, length );
 	play.setFadeIn( fadeIn );
 	play.setFadeOut( fadeOut );
-	auto ret = new AudioBuffer<float>( aud::MaxNumAudioChannels, length );
+	auto ret = new AudioBuffer<float>( aud::getNumPlayedChannels( source ), length );
 	play.process( *ret );
 	return ret;
 }
@@ -64,41 +65,64 @@ AudioBuffer<float>* unc::writePlay( const AudioBuffer<float>& source, int start,
 AudioBuffer<float>* unc::writeLoop( const AudioBuffer<float>& source, int start, int length, int xFade )
 {
 	jassert( xFade <= length );
+	UNC_TRACE_SCOPE( "loop" );
 
-	// loop starts after fade in, length gets trimmed by that amount
-	length -= xFade;
-
-	// loop play from xFade
-	aud::Resampler loop( source );
-	loop.setRange( start + xFade, length );
-	loop.setFadeOut( xFade );
-	auto ret = new AudioBuffer<float>( aud::MaxNumAudioChannels, length );
-	loop.process( *ret );
-
-	// xfade
-	auto end = start + length;
-	aud::Resampler fade( source );
-	fade.setRange( start, xFade );
-	fade.setFadeIn( xFade );
-	AudioBuffer<float> tmp( aud::MaxNumAudioChannels, xFade );
-	fade.process( tmp );
-	aud::addBuffer( tmp, *ret, length - xFade );
+	// loop starts after fade in, length gets trimmed by that amount, its end crossfades into start
+	auto ret = new AudioBuffer<float>( aud::getNumPlayedChannels( source ), length - xFade );
+	aud::renderLoop( source, start, length, xFade, *ret );
+	return ret;
+}
+
+AudioBuffer<float>* unc::writePlay( const aud::SampleBuffer& source, int start, int length, int fadeIn, int fadeOut )
+{
+	// unity ratio reads no samples outside the zone
+	auto zone = source.toFloat( start, length );
+	return writePlay( zone, 0, length, fadeIn, fadeOut );
+}
+
+AudioBuffer<float>* unc::writeLoop( const aud::SampleBuffer& source, int start, int length, int xFade )
+{
+	auto zone = source.toFloat( start, length );
+	return writeLoop( zone, 0, length, xFade );
+}
+
+AudioPlayZone unc::trimZone( const AudioBuffer<float>& source, const AudioPlayZone& zone, float noiseFloor, bool trimStart, bool trimEnd )
+{
+	auto range = Range<int>( zone.start, zone.start + zone.length );
+	auto audible = aud::findAudibleRange( source, range, noiseFloor );
+	if( audible.isEmpty() ){
+		return zone;
+	}
+	if( trimStart ){
+		range.setStart( audible.getStart() );
+	}
+	if( trimEnd ){
+		range.setEnd( audible.getEnd() );
+	}
+	auto ret = zone;
+	ret.start = range.getStart();
+	ret.length = range.getLength();
+	ret.fadeIn = jmin( ret.fadeIn, ret.length );
+	ret.fadeOut = jmin( ret.fadeOut, ret.length - ret.fadeIn );
 	return ret;
 }
 
 // AudioClip - process
-AudioBuffer<float>* AudioClip::writeAudio( int zoneIndex )
+AudioBuffer<float>* AudioClip::writeAudio( int zoneIndex, bool isLoopBaked )
 {
-	if( !isPositiveAndBelow( zoneIndex, sizeZones() ) ){
+	if( !isPositiveAndBelow( zoneIndex, sizeZones() ) || samples == nullptr ){
 		return nullptr;
 	}
 	auto zone = zones[ zoneIndex ];
 	switch( zone.mode ){
 		case AudioPlayMode::Play:{
-			return writePlay( buffer, zone.start, zone.length, zone.fadeIn, zone.fadeOut );
+			return writePlay( *samples, zone.start, zone.length, zone.fadeIn, zone.fadeOut );
 		}
 		case AudioPlayMode::Loop:{
-			return writeLoop( buffer, zone.start, zone.length, zone.fadeOut );
+			if( !isLoopBaked ){
+				return writePlay( *samples, zone.start, zone.length, 0, 0 );
+			}
+			return writeLoop( *samples, zone.start, zone.length, zone.fadeOut );
 		}
 		default:{
 			jassertfalse;
@@ -192,6 +216,20 @@ bool unc::AudioClip::containsZone( const AudioPlayZone& zone ) const
 	return indexOfZone( zone ) >= 0;
 }
 
+AudioClip::Ptr unc::AudioClip::createSnapshot() const
+{
+	auto ret = std::make_shared<AudioClip>();
+	ret->file = file;
+	ret->name = name;
+	ret->samples = samples;
+	ret->zones = zones;
+	ret->sampleRate = sampleRate;
+	ret->bitDepth = bitDepth;
+	ret->contentHash = contentHash;
+	ret->pitch = pitch;
+	return ret;
+}
+
 Result unc::AudioClip::toXml( XmlElement* xml )const
 {
 	if( !file.existsAsFile() ){
@@ -202,6 +240,9 @@ Result unc::AudioClip::toXml( XmlElement* xml )const
 	for( const auto& zone : zones ){
 		zone.toXml( xml->createNewChildElement( "AudioPlayZone" ) );
 	}
+	if( pitch.isAnalysed() ){
+		pitch.toXml( xml->createNewChildElement( "PitchTrack" ) );
+	}
 	return Result::ok();
 }
 
@@ -212,18 +253,22 @@ Result unc::AudioClip::fromXml( XmlElement* xml )
 	String err;
 	bool success = true;
 	AudioSettings settings;
-	buffer = aud::createOrGetBufferFor( file, settings );
-	if( buffer.getNumSamples() == 0 ){
+	samples = aud::createOrGetSamplesFor( file, settings );
+	if( samples == nullptr ){
 		success = false;
 		err += "AudioClip::fromXml() Error reading file " + file.getFullPathName();
 	}
 	sampleRate = settings.sampleRate;
 	bitDepth = settings.bitsPerSample;
+	contentHash = settings.contentHash;
 	forEachXmlChildElementWithTagName( *xml, zoneXml, "AudioPlayZone" ){
 		AudioPlayZone zone;
 		zone.fromXml( zoneXml );
 		success &= addZone( zone );
 	}
+	if( auto* pitchXml = xml->getChildByName( "PitchTrack" ) ){
+		pitch.fromXml( pitchXml );
+	}
 	return success ? Result::ok() : Result::fail( err );
 }
 
@@ -231,10 +276,10 @@ AudioClip::Ptr unc::createAudioClip( const File& file )
 {
 	// make audio buffer, overwrite app audio settings
 	AudioSettings settings = getCurrentAudioSettings();
-	auto buf = aud::createOrGetBufferFor( file, settings );
+	auto samples = aud::createOrGetSamplesFor( file, settings );
 
 	// create audio clip
-	auto ret = createAudioClip( buf, settings, file.getFileNameWithoutExtension());
+	auto ret = createAudioClip( std::move( samples ), settings, file.getFileNameWithoutExtension());
 	if( !ret ){
 		return ret;
 	}
@@ -242,19 +287,25 @@ AudioClip::Ptr unc::createAudioClip( const File& file )
 	return ret;
 }
 
-AudioClip::Ptr unc::createAudioClip( const AudioBuffer<float>& buffer, const AudioSettings& settings, const String& name )
+AudioClip::Ptr unc::createAudioClip( std::shared_ptr<const aud::SampleBuffer> samples, const AudioSettings& settings, const String& name )
 {
-	if( buffer.getNumSamples() == 0 ){
+	if( samples == nullptr || samples->getNumSamples() == 0 ){
 		return nullptr;
 	}
 	auto ret = std::make_shared<AudioClip>();
 	ret->name = name.isEmpty() ? "Unnamed" : name;
-	ret->buffer = buffer;
+	ret->samples = std::move( samples );
 	ret->sampleRate = settings.sampleRate;
 	ret->bitDepth = settings.bitsPerSample;
+	ret->contentHash = settings.contentHash;
 	return ret;
 }
 
+AudioClip::Ptr unc::createAudioClip( const AudioBuffer<float>& buffer, const AudioSettings& settings, const String& name )
+{
+	return createAudioClip( std::make_shared<const aud::SampleBuffer>( buffer, aud::getCompactFormat( settings.bitsPerSample ) ), settings, name );
+}
+
 AudioClip::Ptr unc::createAudioClip()
 {
 	return std::make_shared<AudioClip>();
@@ -3,7 +3,10 @@
 
 #include "MainHeaders.h"
 
+#include "AudioAnalysis.h"
 #include "AudioFunctions.h"
+#include "AudioHash.h"
+#include "AudioPitch.h"
 #include "AudioPlayback.h"
 
 namespace unc
@@ -36,6 +39,10 @@ namespace unc
 
 		// access
 		bool isValid() const{ return start >= 0 && length > 0; }
+		/// \returns length of the audio written for the zone, baked loops are shortened by their crossfade.
+		int getRenderedLength( bool isLoopBaked = true ) const{ return mode == AudioPlayMode::Loop && isLoopBaked ? length - fadeOut : length; }
+		/// \returns first sample of the loop in the audio written for the zone, baked loops loop all of it.
+		int getRenderedLoopStart( bool isLoopBaked = true ) const{ return isLoopBaked ? 0 : fadeOut; }
 		bool operator==( const AudioPlayZone& other )const;
 
 		// persistence
@@ -46,6 +53,15 @@ namespace unc
 
 	AudioBuffer<float>* writePlay( const AudioBuffer<float>& source, int start, int length, int fadeIn, int fadeOut );
 	AudioBuffer<float>* writeLoop( const AudioBuffer<float>& source, int start, int length, int xfade );
+
+	/// Like above, converting only the samples of the zone to float.
+	/// @{
+	AudioBuffer<float>* writePlay( const aud::SampleBuffer& source, int start, int length, int fadeIn, int fadeOut );
+	AudioBuffer<float>* writeLoop( const aud::SampleBuffer& source, int start, int length, int xfade );
+	/// @}
+
+	/// Moves zone start and/or end onto the audible part of source, shortening fades if needed.
+	AudioPlayZone trimZone( const AudioBuffer<float>& source, const AudioPlayZone& zone, float noiseFloor, bool trimStart, bool trimEnd );
 	
 	/// Binds audio data to AudioPlayZones.
 	class AudioClip :	public ChangeBroadcaster
@@ -56,7 +72,8 @@ namespace unc
 		using Ptr = std::shared_ptr<AudioClip>;
 
 		// process
-		AudioBuffer<float>* writeAudio( int zoneIndex );
+		/// \param isLoopBaked crossfades the end of loop zones into their start, otherwise writes them untouched.
+		AudioBuffer<float>* writeAudio( int zoneIndex, bool isLoopBaked = true );
 
 		// modify
 		bool addZone( const AudioPlayZone& zone );
@@ -69,8 +86,14 @@ namespace unc
 		AudioPlayZone getZone( int zoneIndex ) const;
 		int indexOfZone( const AudioPlayZone& zone )const;
 		int sizeZones() const{ return zones.size(); }
-		int getTotalNumSamples() const{ return buffer.getNumSamples(); }
-		int getNumChannels() const{ return buffer.getNumChannels(); }
+		int getTotalNumSamples() const{ return samples != nullptr ? samples->getNumSamples() : 0; }
+		int getNumChannels() const{ return samples != nullptr ? samples->getNumChannels() : 0; }
+
+		/// \returns copy of the clip sharing its samples, for work on other threads while the clip may be edited.
+		AudioClip::Ptr createSnapshot() const;
+
+		/// \returns all audio as float, a temporary copy if stored compact, for analysis.
+		AudioBuffer<float> getAudio() const{ return samples != nullptr ? samples->asFloat() : AudioBuffer<float>(); }
 		bool containsZone( const AudioPlayZone& zone )const;
 
 		// persistence
@@ -79,17 +102,29 @@ namespace unc
 
 		File file;
 		String name;
-		AudioBuffer<float> buffer;
+		std::shared_ptr<const aud::SampleBuffer> samples;
 		AudioPlayZones zones;
 		double sampleRate = 0.;
 		int bitDepth = 0;
 
+		/// Hash of the decoded audio, clips of equal content share their buffer at any sample rate.
+		uint64 contentHash = 0;
+
+		/// \returns key of analysis and thumbnail, shared by clips of equal content and sample rate, 0 if unknown.
+		uint64 getAnalysisKey() const{ return aud::combineWithSampleRate( contentHash, sampleRate ); }
+
+		/// Analysis results, persisted with the clip.
+		aud::PitchTrack pitch;
+
 	private:
 		// modify
 		void sort();
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( AudioClip );
 	};
+	/// \param samples are shared with the clip.
+	AudioClip::Ptr createAudioClip( std::shared_ptr<const aud::SampleBuffer> samples, const AudioSettings& settings, const String& name = String());
+	/// Stores buffer compact if its samples fit the bit depth of settings.
 	AudioClip::Ptr createAudioClip( const AudioBuffer<float>& buffer, const AudioSettings& settings, const String& name = String());
 	AudioClip::Ptr createAudioClip( const File& file );
 	AudioClip::Ptr createAudioClip();
@@ -5,6 +5,24 @@ using namespace unc;
 using namespace lnf;
 
 // AudioClipDisplay
+/// Reads a clip's file, but is cached by content and sample rate, so clips of equal audio share one thumbnail.
+class ContentInputSource : public InputSource
+{
+public:
+	ContentInputSource( const File& file_, uint64 analysisKey ) :
+		file( file_ ),
+		contentHash( analysisKey )
+	{}
+
+	InputStream* createInputStream() override{ return file.createInputStream(); }
+	InputStream* createInputStreamFor( const String& relatedItemPath ) override{ return file.getSiblingFile( relatedItemPath ).createInputStream(); }
+	int64 hashCode() const override{ return ( int64 )contentHash; }
+
+private:
+	File file;
+	uint64 contentHash;
+};
+
 unc::AudioClipDisplay::AudioClipDisplay( Timeline* timeline_ ) :
 	timeline( timeline_ ),
 	thumbnail( 2, *getAudioFormatManager(), *getAudioThumbnailCache())
@@ -24,7 +42,10 @@ unc::AudioClipDisplay::~AudioClipDisplay()
 void AudioClipDisplay::display( AudioClip* other )
 {
 	clip = other;
-	if( other && other->file.existsAsFile() ){
+	if( other && other->file.existsAsFile() && other->getAnalysisKey() != 0 ){
+		thumbnail.setSource( new ContentInputSource( other->file, other->getAnalysisKey() ) );
+	}
+	else if( other && other->file.existsAsFile() ){
 		thumbnail.setSource( new FileInputSource( other->file ));
 	}
 	else{
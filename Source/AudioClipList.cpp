@@ -51,6 +51,30 @@ void unc::AudioClipListModel::selectedRowsChanged( int lastRowSelected )
 }
 
 // AudioClipList
+/// Clips copied for a render in the background, so the originals stay editable meanwhile.
+struct BackgroundRender
+{
+	std::vector<AudioClip::Ptr> snapshots;
+	RenderJobs jobs;
+	RenderSettings settings;
+	Result result = Result::fail( "Render cancelled" );
+};
+
+/// \returns render jobs of copies of clips, kept in snapshots.
+RenderJobs createSnapshotJobs( const AudioClips& clips, const File& outDir, std::vector<AudioClip::Ptr>& snapshots )
+{
+	auto ret = createRenderJobs( clips, outDir );
+	std::map<const AudioClip*, AudioClip*> copies;
+	for( int i = 0; i < clips.size(); ++i ){
+		snapshots.push_back( clips.get( i )->createSnapshot() );
+		copies[ clips.get( i ) ] = snapshots.back().get();
+	}
+	for( auto& job : ret ){
+		job.clip = copies[ job.clip ];
+	}
+	return ret;
+}
+
 unc::AudioClipList::AudioClipList()
 {
 	// listBox
@@ -71,6 +95,30 @@ unc::AudioClipList::AudioClipList()
 	};
 	addAndMakeVisible( outDisplay );
 
+	// normalization
+	addAndMakeVisible( normalizeBox );
+	normalizeBox.addItemList( { "No normalize", "Peak -1 dB", "Loudness -23 LUFS" }, 1 );
+	normalizeBox.setSelectedItemIndex( 0, dontSendNotification );
+	addAndMakeVisible( linkBox );
+	linkBox.addItemList( { "Per file", "Link per clip", "Link all" }, 1 );
+	linkBox.setSelectedItemIndex( 0, dontSendNotification );
+
+	// output format
+	addAndMakeVisible( formatBox );
+	for( int i = 0; i < ( int )aud::FileFormat::NumFormats; ++i ){
+		formatBox.addItem( aud::toString( static_cast< aud::FileFormat >( i ) ), i + 1 );
+	}
+	formatBox.setSelectedItemIndex( 0, dontSendNotification );
+	addAndMakeVisible( bitsBox );
+	bitsBox.addItemList( { "16 bit", "16 bit shaped", "24 bit", "32 bit float" }, 1 );
+	bitsBox.setSelectedItemIndex( 2, dontSendNotification );
+	addAndMakeVisible( layoutBox );
+	layoutBox.addItemList( { "File per zone", "Pack + SFZ" }, 1 );
+	layoutBox.setSelectedItemIndex( 0, dontSendNotification );
+	addAndMakeVisible( loopBox );
+	loopBox.addItemList( { "Baked loops", "Loop markers" }, 1 );
+	loopBox.setSelectedItemIndex( 0, dontSendNotification );
+
 	// renderButton
 	addAndMakeVisible( renderButton );
 	renderButton.onClick = [ & ](){
@@ -78,31 +126,45 @@ unc::AudioClipList::AudioClipList()
 			return;
 		}
 		if( !File::isAbsolutePath( outPath.getFullPathName())){
-			AlertWindow::showMessageBox( AlertWindow::WarningIcon, "Error", "Choose valid outpath." );
+			AlertWindow::showMessageBoxAsync( AlertWindow::WarningIcon, "Error", "Choose valid outpath." );
 			return;
 		}
-		for( int clipIdx = 0; clipIdx < clips->size(); ++clipIdx ){
-			auto* clip = clips->get( clipIdx );
-			for( int zoneIdx = 0; zoneIdx < clip->sizeZones(); ++zoneIdx ){
-				std::unique_ptr<AudioBuffer<float>> buf( clip->writeAudio( zoneIdx ) );
-				if( !buf ){
-					return;
-				}
-				auto path = outPath.getFullPathName();
-				path += File::getSeparatorString();
-				path += clip->getName();
-				path += "_";
-				path += String( zoneIdx );
-				path += "_";
-				path += clip->getZone( zoneIdx ).name;
-				path += ".wav";
-				File file( path );
-				if( file.create().wasOk()){
-					aud::writeToFile( file, *buf, getCurrentAudioSettings() );
-				}
-			}
+		auto render = std::make_shared<BackgroundRender>();
+		render->jobs = createSnapshotJobs( *clips, outPath, render->snapshots );
+		auto& settings = render->settings;
+		settings.normalization = getNormalization();
+		settings.output = getOutputFormat();
+		settings.isLoopBaked = loopBox.getSelectedItemIndex() != 1;
+		settings.cancel = beginTask();
+		const auto isPack = layoutBox.getSelectedItemIndex() == 1;
+		const auto sfzFile = outPath.getChildFile( "pack.sfz" );
+		if( !isPack ){
+			settings.journal = getRenderJournalFor( outPath );
 		}
-		AlertWindow::showMessageBox( AlertWindow::InfoIcon, "Success", "Sample render complete." );
+		// linked gains are measured by a job of their own, the render runs after it
+		std::vector<JobScheduler::JobPtr> after;
+		if( settings.normalization.isActive() && settings.normalization.link != aud::Normalization::PerFile ){
+			after.push_back( getJobScheduler()->add( [ render ](){
+				render->settings.linkedGains = measureLinkedGains( render->jobs, render->settings );
+			}, JobPriority::Batch, settings.cancel ) );
+		}
+		SafePointer<AudioClipList> safeThis( this );
+		runInBackground( [ render, isPack, sfzFile ](){
+			render->result = isPack ? renderPack( render->jobs, render->settings, sfzFile ) : unc::render( render->jobs, render->settings );
+		}, [ safeThis, render ](){
+			if( safeThis ){
+				safeThis->endTask();
+			}
+			if( render->result.failed() ){
+				AlertWindow::showMessageBoxAsync( AlertWindow::WarningIcon, "Error", render->result.getErrorMessage() );
+				return;
+			}
+			AlertWindow::showMessageBoxAsync( AlertWindow::InfoIcon, "Success", "Sample render complete." );
+		}, JobPriority::Batch, settings.cancel, after );
+	};
+	addChildComponent( cancelButton );
+	cancelButton.onClick = [ & ](){
+		taskToken.cancel();
 	};
 	// commands
 	getApplicationCommandManager()->registerAllCommandsForTarget( this );
@@ -111,6 +173,7 @@ unc::AudioClipList::AudioClipList()
 
 unc::AudioClipList::~AudioClipList()
 {
+	taskToken.cancel();
 	if( clips ){
 		clips->removeChangeListener( this );
 	}
@@ -153,6 +216,23 @@ void unc::AudioClipList::resized()
 
 	// renderButton
 	renderButton.setBounds( lo.removeFromRight( dims::wM ));
+	cancelButton.setBounds( renderButton.getBounds() );
+	lo.removeFromRight( dims::pad );
+
+	// output format
+	loopBox.setBounds( lo.removeFromRight( dims::wM ));
+	lo.removeFromRight( dims::pad );
+	layoutBox.setBounds( lo.removeFromRight( dims::wM ));
+	lo.removeFromRight( dims::pad );
+	bitsBox.setBounds( lo.removeFromRight( dims::wL ));
+	lo.removeFromRight( dims::pad );
+	formatBox.setBounds( lo.removeFromRight( dims::wM ));
+	lo.removeFromRight( dims::pad );
+
+	// normalization
+	linkBox.setBounds( lo.removeFromRight( dims::wL ));
+	lo.removeFromRight( dims::pad );
+	normalizeBox.setBounds( lo.removeFromRight( dims::wL ));
 	lo.removeFromRight( dims::pad );
 
 	// outDisplay
@@ -174,6 +254,49 @@ void unc::AudioClipList::selectRow( int row )
 	};
 }
 
+// AudioClipList - process
+CancelToken unc::AudioClipList::beginTask()
+{
+	++numTasks;
+	renderButton.setVisible( false );
+	cancelButton.setVisible( true );
+	return taskToken;
+}
+
+void unc::AudioClipList::endTask()
+{
+	jassert( numTasks > 0 );
+	if( --numTasks > 0 ){
+		return;
+	}
+	// later work must not inherit a cancel
+	taskToken = CancelToken();
+	cancelButton.setVisible( false );
+	renderButton.setVisible( true );
+}
+
+// AudioClipList - access
+aud::Normalization unc::AudioClipList::getNormalization() const
+{
+	aud::Normalization ret;
+	ret.mode = static_cast< aud::Normalization::Mode >( jmax( 0, normalizeBox.getSelectedItemIndex() ) );
+	ret.link = static_cast< aud::Normalization::Link >( jmax( 0, linkBox.getSelectedItemIndex() ) );
+	return ret;
+}
+
+aud::OutputFormat unc::AudioClipList::getOutputFormat() const
+{
+	aud::OutputFormat ret;
+	ret.format = static_cast< aud::FileFormat >( jmax( 0, formatBox.getSelectedItemIndex() ) );
+	switch( bitsBox.getSelectedItemIndex() ){
+		case 0: ret.bitsPerSample = 16; break;
+		case 1: ret.bitsPerSample = 16; ret.noiseShaping = true; break;
+		case 3: ret.bitsPerSample = 32; break;
+		default: ret.bitsPerSample = 24; break;
+	}
+	return ret;
+}
+
 Array<AudioClip*> unc::AudioClipList::getListSelection() const
 {
 	Array<AudioClip*> ret;
@@ -268,17 +391,43 @@ void unc::AudioClipList::filesDropped( const StringArray& files, int x, int y )
 		jassertfalse;
 		return;
 	}
-	getUndoManager()->beginNewTransaction( "AddAudioClip from files" );
+	// decode dropped files on all cores ahead of background work, add them as AudioClips in drop order
+	Array<File> newFiles;
 	for( const auto& s : files ){
-		
-		// add dropped files as AudioClips
 		File f( s );
-		if( f.existsAsFile() && !clips->containsWith( f )){
-			if( auto clip = createAudioClip( f ) ){
+		if( f.existsAsFile() && !clips->containsWith( f ) && !newFiles.contains( f ) ){
+			newFiles.add( f );
+		}
+	}
+	if( newFiles.isEmpty() ){
+		return;
+	}
+	auto newClips = std::make_shared<std::vector<AudioClip::Ptr>>( ( size_t )newFiles.size() );
+	const auto token = beginTask();
+	SafePointer<AudioClipList> safeThis( this );
+	runInBackground( [ newFiles, newClips, token ](){
+		aud::parallelFor( newFiles.size(), [ & ]( int i ){
+			if( !token.isCancelled() ){
+				( *newClips )[ ( size_t )i ] = createAudioClip( newFiles[ i ] );
+			}
+		}, JobPriority::Interactive );
+	}, [ safeThis, newClips, token ](){
+		if( !safeThis ){
+			return;
+		}
+		safeThis->endTask();
+		auto* clips = safeThis->clips;
+		if( token.isCancelled() || !clips ){
+			return;
+		}
+		// files dropped twice meanwhile are added once
+		getUndoManager()->beginNewTransaction( "AddAudioClip from files" );
+		for( const auto& clip : *newClips ){
+			if( clip && !clips->containsWith( clip->file ) ){
 				getUndoManager()->perform( new AddAudioClipCommand( clips, clip ));
 			}
 		}
-	}
-	// list size change
-	resized();
+		// list size change
+		safeThis->resized();
+	}, JobPriority::Interactive, token );
 }
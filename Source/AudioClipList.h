@@ -6,6 +6,8 @@
 
 #include "AudioClip.h"
 #include "AudioCommands.h"
+#include "AudioPack.h"
+#include "AudioRender.h"
 #include "Commands.h"
 #include "MainInterface.h"
 
@@ -45,8 +47,17 @@ namespace unc
 		// modify
 		void selectRow( int row );
 
+		// process
+		/// Starts work running in the background, the Cancel button replaces Render until all work begun has ended.
+		/// \returns token cancelled by the Cancel button, shared by all work running at once.
+		CancelToken beginTask();
+		void endTask();
+		bool isBusy() const{ return numTasks > 0; }
+
 		// access
 		Array<AudioClip*> getListSelection() const;
+		aud::Normalization getNormalization() const;
+		aud::OutputFormat getOutputFormat() const;
 		int getRowHeight() const{ return lnf::dims::h + lnf::dims::pad; }
 
 		// ApplicationCommandTarget
@@ -70,7 +81,16 @@ namespace unc
 		TextButton outButton{ "Outpath" };
 		Label outDisplay{ "outDisplay" };
 		File outPath;
+		ComboBox normalizeBox{ "normalizeBox" };
+		ComboBox linkBox{ "linkBox" };
+		ComboBox formatBox{ "formatBox" };
+		ComboBox bitsBox{ "bitsBox" };
+		ComboBox layoutBox{ "layoutBox" };
+		ComboBox loopBox{ "loopBox" };
 		TextButton renderButton{ "Render" };
+		TextButton cancelButton{ "Cancel" };
+		CancelToken taskToken;
+		int numTasks = 0;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( AudioClipList );
 	};
@@ -13,6 +13,7 @@ namespace unc
 		void runTest() override
 		{
 			testWriteZone();
+			testWriteZoneChannels();
 		}
 
 		void testWriteZone()
@@ -44,6 +45,27 @@ namespace unc
 			expectWithinAbsoluteError( loop->getSample( 0, 2 ), 0.5f, 0.00001f );
 			expectWithinAbsoluteError( loop->getSample( 0, 3 ), 0.4f, 0.00001f );
 		}
+
+		void testWriteZoneChannels()
+		{
+			beginTest( "testWriteZoneChannels" );
+
+			// source channels are kept, not folded to stereo
+			AudioBuffer<float> b( 6, 8 );
+			for( int ch = 0; ch < b.getNumChannels(); ++ch ){
+				for( int i = 0; i < b.getNumSamples(); ++i ){
+					b.setSample( ch, i, 0.1f * ( ch + 1 ) );
+				}
+			}
+			std::unique_ptr<AudioBuffer<float>> play( writePlay( b, 0, 4, 0, 0 ) );
+			std::unique_ptr<AudioBuffer<float>> loop( writeLoop( b, 0, 6, 2 ) );
+			expectEquals( play->getNumChannels(), 6 );
+			expectEquals( loop->getNumChannels(), 6 );
+			for( int ch = 0; ch < b.getNumChannels(); ++ch ){
+				expectWithinAbsoluteError( play->getSample( ch, 1 ), 0.1f * ( ch + 1 ), 0.00001f );
+				expectWithinAbsoluteError( loop->getSample( ch, 1 ), 0.1f * ( ch + 1 ), 0.00001f );
+			}
+		}
 	};
 	static AudioClipTest audioClipTest;
 }
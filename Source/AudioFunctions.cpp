@@ -1,87 +1,123 @@
 // Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
 #include "AudioFunctions.h"
 
+#include "AudioHash.h"
+
 using namespace aud;
 
-// writeToFile
-bool aud::writeToFile( const File& targetFile, const AudioBuffer<float>& audio, const AudioSettings& settings )
-{
-	std::unique_ptr<FileOutputStream> fos( new FileOutputStream( targetFile.withFileExtension( "wav" ) ) );
+// decodeAudioFile
+const static int DecodeBlockLength( 65536 );
 
-	// prepare to overwrite file
-	if( fos->openedOk() ){
-		fos->setPosition( 0 );
-		fos->truncate();
+AudioBuffer<float> aud::decodeAudioFile( const File& file, AudioSettings& settings )
+{
+	UNC_TRACE_SCOPE( "decode" );
+	UNC_TRACE_BYTES( "read", file.getSize() );
 
-		// create wav writer and write, writer owns fos
-		std::unique_ptr<AudioFormatWriter> writer( WavAudioFormat().createWriterFor( fos.release(), settings.sampleRate, audio.getNumChannels(), settings.bitsPerSample, StringPairArray(), 0 ) );
-		writer->writeFromAudioSampleBuffer( audio, 0, audio.getNumSamples() );
-		return true;
+	// create reader
+	std::unique_ptr<AudioFormatReader> rd( getAudioFormatManager()->createReaderFor( file ) );
+	if( rd == nullptr ){
+		return AudioBuffer<float>();
 	}
-	return false;
+	// read sample data into buffer in blocks, hashing each while it is still in cache
+	const auto len = ( int )rd->lengthInSamples;
+	AudioBuffer<float> buf( ( int )rd->numChannels, len );
+	std::vector<ContentHasher> hashers( ( size_t )buf.getNumChannels() );
+	for( int pos = 0; pos < len; pos += DecodeBlockLength ){
+		const auto num = jmin( DecodeBlockLength, len - pos );
+		rd->read( &buf, pos, num, pos, true, true );
+		for( int ch = 0; ch < buf.getNumChannels(); ++ch ){
+			hashers[ ( size_t )ch ].update( buf.getReadPointer( ch, pos ), sizeof( float ) * ( size_t )num );
+		}
+	}
+	std::vector<uint64> channelHashes;
+	for( auto& hasher : hashers ){
+		channelHashes.push_back( hasher.getHash() );
+	}
+	settings.sampleRate = rd->sampleRate;
+	settings.bufferSize = len;
+	settings.bitsPerSample = rd->bitsPerSample;
+	settings.contentHash = combineChannelHashes( channelHashes.data(), buf.getNumChannels(), len );
+	return buf;
 }
 
-// createOrGetBufferFor
-std::map<File, AudioBuffer<float>>& getAudioCache()
+// createOrGetSamplesFor
+/// Decoded audio by content hash, files of equal content share one buffer.
+std::map<uint64, std::shared_ptr<const SampleBuffer>>& getAudioCache()
 {
-	static std::map<File, AudioBuffer<float>> ret;
+	static std::map<uint64, std::shared_ptr<const SampleBuffer>> ret;
 	return ret;
 }
 
-bool hasSharedAudioBuffer( const File& name )
+/// Properties of decoded files by path, valid while size and modification time match, so unchanged files skip decoding.
+struct DecodedFile
 {
-	return getAudioCache().find( name ) != getAudioCache().end();
-}
+	int64 size = 0;
+	Time modified;
+	AudioSettings settings;
+};
 
-void addSharedAudioBuffer( const File& name, AudioBuffer<float>&& buffer )
+std::map<String, DecodedFile>& getFileCache()
 {
-	if( hasSharedAudioBuffer( name ) ){
-		return;
-	}
-	getAudioCache()[ name ] = std::move( buffer );
+	static std::map<String, DecodedFile> ret;
+	return ret;
 }
 
-void clearSharedAudioBuffers()
+/// Guards both caches, files are decoded and compared outside of it.
+CriticalSection& getCacheLock()
 {
-	getAudioCache().clear();
+	static CriticalSection ret;
+	return ret;
 }
 
-AudioBuffer<float> getSharedAudioBuffer( const File& name )
+/// Copies the file properties of source to settings, leaving the others.
+void copyFileSettings( const AudioSettings& source, AudioSettings& settings )
 {
-	// should call aud::createOrGetBufferFor()
-	if( !hasSharedAudioBuffer( name ) ){
-		jassertfalse;
-		return AudioBuffer<float>();
-	}
-	// add to cache
-	auto& buf = getAudioCache()[ name ];
-	AudioBuffer<float> ret( buf.getArrayOfWritePointers(), buf.getNumChannels(), buf.getNumSamples() );
-	return ret;
+	settings.sampleRate = source.sampleRate;
+	settings.bufferSize = source.bufferSize;
+	settings.bitsPerSample = source.bitsPerSample;
+	settings.contentHash = source.contentHash;
 }
 
-AudioBuffer<float> aud::createOrGetBufferFor( const File& file, AudioSettings& settings )
+std::shared_ptr<const SampleBuffer> aud::createOrGetSamplesFor( const File& file, AudioSettings& settings )
 {
-	// create reader
-	std::unique_ptr<AudioFormatReader> rd( getAudioFormatManager()->createReaderFor( file ) );
-	if( rd == nullptr ){
-		return AudioBuffer<float>();
+	// unchanged files were decoded before
+	const auto path = file.getFullPathName();
+	const auto size = file.getSize();
+	const auto modified = file.getLastModificationTime();
+	auto& files = getFileCache();
+	{
+		const ScopedLock lock( getCacheLock() );
+		auto known = files.find( path );
+		if( known != files.end() && known->second.size == size && known->second.modified == modified ){
+			copyFileSettings( known->second.settings, settings );
+			return getAudioCache()[ known->second.settings.contentHash ];
+		}
 	}
-	// read sample data into buffer
-	auto len = rd->lengthInSamples;
-	AudioBuffer<float> buf( rd->numChannels, len );
-	rd->read( &buf, 0, ( int32 )len, 0, true, true );
-	settings.sampleRate = rd->sampleRate;
-	settings.bufferSize = rd->lengthInSamples;
-	settings.bitsPerSample = rd->bitsPerSample;
+	// files are read once, their content hash is taken while decoding
+	AudioSettings decoded;
+	auto buf = decodeAudioFile( file, decoded );
+	if( buf.getNumSamples() == 0 ){
+		return nullptr;
+	}
+	copyFileSettings( decoded, settings );
+	auto samples = std::make_shared<const SampleBuffer>( buf, getCompactFormat( decoded.bitsPerSample ) );
 
-	// check if sample already exists in shared cache.
-	if( hasSharedAudioBuffer( file ) ){
-		auto shared = getSharedAudioBuffer( file );
-		if( compareBuffer( buf, shared )){
-			return shared;
+	// equal samples from another file share its buffer
+	std::shared_ptr<const SampleBuffer> shared;
+	{
+		const ScopedLock lock( getCacheLock() );
+		auto& cached = getAudioCache()[ decoded.contentHash ];
+		if( cached == nullptr ){
+			cached = samples;
 		}
+		shared = cached;
+	}
+	// a hash collision keeps its own, compared without holding the lock
+	if( shared != samples && !shared->hasSameSamples( *samples ) ){
+		jassertfalse;
+		return samples;
 	}
-	// put in cache and return
-	addSharedAudioBuffer( file, std::move( buf ) );
-	return getSharedAudioBuffer( file );
+	const ScopedLock lock( getCacheLock() );
+	files[ path ] = { size, modified, decoded };
+	return shared;
 }
@@ -3,6 +3,9 @@
 
 #include "MainHeaders.h"
 
+#include "AudioStorage.h"
+#include "Trace.h"
+
 namespace aud
 {
 	/// \returns evenly spaced values for logarithmically decreasing input (1., 0.5., 0.25).
@@ -29,22 +32,16 @@ namespace aud
 		}
 	}
 
-	/// \returns true if the two buffers are identical.
-	inline bool compareBuffer( const AudioBuffer<float>& first, const AudioBuffer<float> second )
+	/// \returns true if the two buffers hold bitwise identical audio, stops at the first difference.
+	inline bool compareBuffer( const AudioBuffer<float>& first, const AudioBuffer<float>& second )
 	{
-		if( first.getNumSamples() != second.getNumSamples() ){
-			return false;
-		}
-		const auto numSamps = first.getNumSamples();
-		if( first.getNumChannels() != second.getNumChannels() ){
+		if( first.getNumSamples() != second.getNumSamples() || first.getNumChannels() != second.getNumChannels() ){
 			return false;
 		}
-		const auto numChans = first.getNumChannels();
-		for( int chan = 0; chan < numChans; ++chan ){
-			for( int samp = 0; samp < numSamps; ++samp ){
-				if( first.getSample( chan, samp ) != second.getSample( chan, samp ) ){
-					return false;
-				}
+		const auto numBytes = sizeof( float ) * ( size_t )first.getNumSamples();
+		for( int chan = 0; chan < first.getNumChannels(); ++chan ){
+			if( memcmp( first.getReadPointer( chan ), second.getReadPointer( chan ), numBytes ) != 0 ){
+				return false;
 			}
 		}
 		return true;
@@ -96,10 +93,14 @@ namespace aud
 		copyBuffer( source, dest, 0 );
 	}
 
-	/// Writes wav 24 bit.
-	/// \returns true if successful.
-	bool writeToFile( const File& targetFile, const AudioBuffer<float>& audio, const AudioSettings& settings );
+	/// Decodes audio file without caching, settings receive the file's properties and content hash.
+	/// \returns an empty buffer if the file can not be read.
+	AudioBuffer<float> decodeAudioFile( const File& audioFile, AudioSettings& settings );
 
-	/// Convert audio file to an AudioBuffer and cache as shared data.
-	AudioBuffer<float> createOrGetBufferFor( const File& audioFile, AudioSettings& settings );
+	/// Convert audio file to samples and cache as shared data, settings receive the file's properties and content hash.
+	/// Files of equal content share one immutable buffer, files unchanged since their last call are not read again.
+	/// Integer files are stored in the compact format of their bit depth.
+	/// Thread safe, so files can be imported in parallel.
+	/// \returns nullptr if the file can not be read.
+	std::shared_ptr<const SampleBuffer> createOrGetSamplesFor( const File& audioFile, AudioSettings& settings );
 }
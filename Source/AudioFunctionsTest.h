@@ -13,6 +13,7 @@ namespace aud
 		void runTest() override
 		{
 			testAudioCopy();
+			testSharedContent();
 		}
 
 		void testAudioCopy()
@@ -31,6 +32,60 @@ namespace aud
 			expectEquals( d.getSample( 1, 0 ), 0.3f );
 			expectEquals( d.getSample( 1, 1 ), 0.4f );
 		}
+
+		/// Writes buffer as 24 bit file of format.
+		void writeFile( const File& file, AudioFormat& format, const AudioBuffer<float>& buffer )
+		{
+			file.deleteFile();
+			std::unique_ptr<AudioFormatWriter> writer( format.createWriterFor( file.createOutputStream(), 44100., ( unsigned int )buffer.getNumChannels(), 24, {}, 0 ) );
+			writer->writeFromAudioSampleBuffer( buffer, 0, buffer.getNumSamples() );
+		}
+
+		void testSharedContent()
+		{
+			beginTest( "testSharedContent" );
+
+			AudioBuffer<float> b( 2, 1000 );
+			Random random( 4 );
+			for( int ch = 0; ch < b.getNumChannels(); ++ch ){
+				for( int i = 0; i < b.getNumSamples(); ++i ){
+					b.setSample( ch, i, random.nextFloat() - 0.5f );
+				}
+			}
+			// byte equal copies and the same samples in another format
+			TemporaryFile first( ".wav" );
+			TemporaryFile copy( ".wav" );
+			TemporaryFile other( ".aif" );
+			WavAudioFormat wav;
+			AiffAudioFormat aiff;
+			writeFile( first.getFile(), wav, b );
+			writeFile( copy.getFile(), wav, b );
+			writeFile( other.getFile(), aiff, b );
+
+			// all share one buffer
+			AudioSettings firstSettings, copySettings, otherSettings;
+			auto firstSamples = createOrGetSamplesFor( first.getFile(), firstSettings );
+			auto copied = createOrGetSamplesFor( copy.getFile(), copySettings );
+			auto otherSamples = createOrGetSamplesFor( other.getFile(), otherSettings );
+			expect( firstSettings.contentHash != 0 );
+			expect( copySettings.contentHash == firstSettings.contentHash );
+			expect( otherSettings.contentHash == firstSettings.contentHash );
+			expect( copied == firstSamples );
+			expect( otherSamples == firstSamples );
+			expectEquals( copySettings.bitsPerSample, 24 );
+
+			// stored in 24 bit without loss
+			expect( firstSamples->getFormat() == SampleFormat::Int24 );
+			auto decoded = firstSamples->asFloat();
+			AudioSettings settings;
+			expect( compareBuffer( decoded, decodeAudioFile( first.getFile(), settings ) ) );
+
+			// a changed file is decoded again
+			writeFile( copy.getFile(), wav, AudioBuffer<float>( 2, 500 ) );
+			auto changed = createOrGetSamplesFor( copy.getFile(), copySettings );
+			expect( changed != firstSamples );
+			expectEquals( changed->getNumSamples(), 500 );
+		}
 	};
 	static AudioFunctionTest audioFunctionTest;
 }
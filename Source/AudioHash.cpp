@@ -0,0 +1,190 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioHash.h"
+
+using namespace aud;
+
+const static uint64 Prime1( 11400714785074694791ULL );
+const static uint64 Prime2( 14029467366897019727ULL );
+const static uint64 Prime3( 1609587929392839161ULL );
+const static uint64 Prime4( 9650029242287828579ULL );
+const static uint64 Prime5( 2870177450012600261ULL );
+
+// bytes of a file hashed at once
+const static int FileBlockLength( 65536 );
+
+inline uint64 rotateLeft( uint64 x, int bits )
+{
+	return ( x << bits ) | ( x >> ( 64 - bits ) );
+}
+
+inline uint64 readLittleEndian64( const uint8* p )
+{
+	uint64 ret;
+	memcpy( &ret, p, sizeof( ret ) );
+	return ByteOrder::swapIfBigEndian( ret );
+}
+
+inline uint32 readLittleEndian32( const uint8* p )
+{
+	uint32 ret;
+	memcpy( &ret, p, sizeof( ret ) );
+	return ByteOrder::swapIfBigEndian( ret );
+}
+
+inline uint64 hashRound( uint64 lane, uint64 input )
+{
+	lane += input * Prime2;
+	return rotateLeft( lane, 31 ) * Prime1;
+}
+
+inline uint64 mergeRound( uint64 hash, uint64 lane )
+{
+	hash ^= hashRound( 0, lane );
+	return hash * Prime1 + Prime4;
+}
+
+/// Consumes whole 32 byte stripes of data.
+/// \returns number of bytes consumed.
+size_t consumeStripes( uint64* lanes, const uint8* data, size_t numBytes )
+{
+	auto v1 = lanes[ 0 ];
+	auto v2 = lanes[ 1 ];
+	auto v3 = lanes[ 2 ];
+	auto v4 = lanes[ 3 ];
+	size_t pos = 0;
+	for( ; pos + 32 <= numBytes; pos += 32 ){
+		v1 = hashRound( v1, readLittleEndian64( data + pos ) );
+		v2 = hashRound( v2, readLittleEndian64( data + pos + 8 ) );
+		v3 = hashRound( v3, readLittleEndian64( data + pos + 16 ) );
+		v4 = hashRound( v4, readLittleEndian64( data + pos + 24 ) );
+	}
+	lanes[ 0 ] = v1;
+	lanes[ 1 ] = v2;
+	lanes[ 2 ] = v3;
+	lanes[ 3 ] = v4;
+	return pos;
+}
+
+// ContentHasher
+aud::ContentHasher::ContentHasher( uint64 seed_ ) :
+	seed( seed_ )
+{
+	lanes[ 0 ] = seed + Prime1 + Prime2;
+	lanes[ 1 ] = seed + Prime2;
+	lanes[ 2 ] = seed;
+	lanes[ 3 ] = seed - Prime1;
+}
+
+// ContentHasher - modify
+void aud::ContentHasher::update( const void* data, size_t numBytes )
+{
+	auto* bytes = static_cast<const uint8*>( data );
+	totalBytes += numBytes;
+
+	// complete a pending stripe first
+	if( numPending > 0 ){
+		const auto num = jmin( numBytes, sizeof( pending ) - numPending );
+		memcpy( pending + numPending, bytes, num );
+		numPending += num;
+		bytes += num;
+		numBytes -= num;
+		if( numPending < sizeof( pending ) ){
+			return;
+		}
+		consumeStripes( lanes, pending, sizeof( pending ) );
+		numPending = 0;
+	}
+	const auto consumed = consumeStripes( lanes, bytes, numBytes );
+	numPending = numBytes - consumed;
+	memcpy( pending, bytes + consumed, numPending );
+}
+
+// ContentHasher - access
+uint64 aud::ContentHasher::getHash() const
+{
+	uint64 hash;
+	if( totalBytes >= 32 ){
+		hash = rotateLeft( lanes[ 0 ], 1 ) + rotateLeft( lanes[ 1 ], 7 ) + rotateLeft( lanes[ 2 ], 12 ) + rotateLeft( lanes[ 3 ], 18 );
+		for( auto lane : lanes ){
+			hash = mergeRound( hash, lane );
+		}
+	}
+	else{
+		hash = seed + Prime5;
+	}
+	hash += totalBytes;
+
+	// tail of less than a stripe
+	const auto* p = pending;
+	const auto* end = pending + numPending;
+	for( ; p + 8 <= end; p += 8 ){
+		hash ^= hashRound( 0, readLittleEndian64( p ) );
+		hash = rotateLeft( hash, 27 ) * Prime1 + Prime4;
+	}
+	if( p + 4 <= end ){
+		hash ^= readLittleEndian32( p ) * Prime1;
+		hash = rotateLeft( hash, 23 ) * Prime2 + Prime3;
+		p += 4;
+	}
+	for( ; p < end; ++p ){
+		hash ^= *p * Prime5;
+		hash = rotateLeft( hash, 11 ) * Prime1;
+	}
+	// avalanche
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+// combineChannelHashes
+uint64 aud::combineChannelHashes( const uint64* channelHashes, int numChannels, int numSamples )
+{
+	// dimensions are part of the content, silence of different lengths differs
+	ContentHasher hasher;
+	const int64 dims[] = { numChannels, numSamples };
+	hasher.update( dims, sizeof( dims ) );
+	hasher.update( channelHashes, sizeof( uint64 ) * ( size_t )numChannels );
+	return hasher.getHash();
+}
+
+// combineWithSampleRate
+uint64 aud::combineWithSampleRate( uint64 contentHash, double sampleRate )
+{
+	if( contentHash == 0 ){
+		return 0;
+	}
+	ContentHasher hasher;
+	hasher.update( &contentHash, sizeof( contentHash ) );
+	hasher.update( &sampleRate, sizeof( sampleRate ) );
+	return hasher.getHash();
+}
+
+// hashFile
+uint64 aud::hashFile( const File& file )
+{
+	FileInputStream stream( file );
+	if( stream.failedToOpen() ){
+		return 0;
+	}
+	ContentHasher hasher;
+	HeapBlock<char> block( FileBlockLength );
+	for( int num; ( num = stream.read( block, FileBlockLength ) ) > 0; ){
+		hasher.update( block, ( size_t )num );
+	}
+	return hasher.getHash();
+}
+
+// hashBuffer
+uint64 aud::hashBuffer( const AudioBuffer<float>& buffer )
+{
+	HeapBlock<uint64> channelHashes( buffer.getNumChannels() );
+	for( int ch = 0; ch < buffer.getNumChannels(); ++ch ){
+		ContentHasher hasher;
+		hasher.update( buffer.getReadPointer( ch ), sizeof( float ) * ( size_t )buffer.getNumSamples() );
+		channelHashes[ ch ] = hasher.getHash();
+	}
+	return combineChannelHashes( channelHashes, buffer.getNumChannels(), buffer.getNumSamples() );
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+namespace aud
+{
+	/// Incremental 64 bit content hash, digests match xxHash64.
+	/// Four independent lanes per 32 byte stripe, so the compiler can interleave them.
+	class ContentHasher
+	{
+	public:
+		ContentHasher( uint64 seed = 0 );
+
+		// modify
+		void update( const void* data, size_t numBytes );
+
+		// access
+		/// \returns hash of all data so far, more may be added after.
+		uint64 getHash() const;
+
+	private:
+		uint64 seed;
+		uint64 totalBytes = 0;
+		uint64 lanes[ 4 ];
+		uint8 pending[ 32 ];
+		size_t numPending = 0;
+
+		JUCE_LEAK_DETECTOR( ContentHasher );
+	};
+
+	/// \returns content hash of audio given the hashes of its channels, each of numSamples.
+	uint64 combineChannelHashes( const uint64* channelHashes, int numChannels, int numSamples );
+
+	/// \returns content hash of the file's bytes, read in blocks, 0 if it can not be read.
+	uint64 hashFile( const File& file );
+
+	/// \returns content hash of buffer, equal for bitwise equal audio. Same as hashing each channel while decoding.
+	uint64 hashBuffer( const AudioBuffer<float>& buffer );
+
+	/// \returns key of results that depend on sampleRate as well as on the samples of contentHash, e.g. pitch or thumbnails.
+	/// 0 if contentHash is 0, as it is unknown then.
+	uint64 combineWithSampleRate( uint64 contentHash, double sampleRate );
+}
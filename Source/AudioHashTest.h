@@ -0,0 +1,103 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "AudioHash.h"
+#include "AudioFunctions.h"
+
+namespace aud
+{
+	class AudioHashTest : public UnitTest
+	{
+	public:
+		AudioHashTest() : UnitTest( "AudioHashTest" ){}
+
+		void runTest() override
+		{
+			testContentHasher();
+			testHashBuffer();
+			testCompareBuffer();
+		}
+
+		void testContentHasher()
+		{
+			beginTest( "testContentHasher" );
+
+			// reference digests of xxHash64
+			auto hash = []( const char* text ){
+				ContentHasher hasher;
+				hasher.update( text, strlen( text ) );
+				return hasher.getHash();
+			};
+			expect( hash( "" ) == 0xef46db3751d8e999ULL );
+			expect( hash( "abc" ) == 0x44bc2cf5ad770999ULL );
+			expect( hash( "Nobody inspects the spammish repetition" ) == 0xfbcea83c8a378bf1ULL );
+
+			// pieces of any size hash like the whole
+			HeapBlock<uint8> data( 1000 );
+			for( int i = 0; i < 1000; ++i ){
+				data[ i ] = ( uint8 )( i * 31 + 7 );
+			}
+			ContentHasher whole;
+			whole.update( data, 1000 );
+			ContentHasher pieces;
+			for( int pos = 0, step = 1; pos < 1000; pos += step, step = step * 3 % 97 ){
+				pieces.update( data + pos, ( size_t )jmin( step, 1000 - pos ) );
+			}
+			expect( whole.getHash() == pieces.getHash() );
+
+			// files hash like their bytes, across read blocks
+			TemporaryFile temp;
+			MemoryBlock bytes( 200000 );
+			for( size_t i = 0; i < bytes.getSize(); ++i ){
+				bytes[ i ] = ( char )( i * 31 + 7 );
+			}
+			expect( temp.getFile().replaceWithData( bytes.getData(), bytes.getSize() ) );
+			ContentHasher fileBytes;
+			fileBytes.update( bytes.getData(), bytes.getSize() );
+			expect( hashFile( temp.getFile() ) == fileBytes.getHash() );
+			expect( hashFile( File() ) == 0 );
+		}
+
+		void testHashBuffer()
+		{
+			beginTest( "testHashBuffer" );
+
+			AudioBuffer<float> b( 2, 100 );
+			Random random( 3 );
+			for( int ch = 0; ch < b.getNumChannels(); ++ch ){
+				for( int i = 0; i < b.getNumSamples(); ++i ){
+					b.setSample( ch, i, random.nextFloat() );
+				}
+			}
+			AudioBuffer<float> copy( b );
+			expect( hashBuffer( b ) == hashBuffer( copy ) );
+
+			// any sample or dimension changes it
+			copy.setSample( 1, 99, 0.f );
+			expect( hashBuffer( b ) != hashBuffer( copy ) );
+			AudioBuffer<float> longSilence( 1, 8 );
+			AudioBuffer<float> shortSilence( 1, 4 );
+			longSilence.clear();
+			shortSilence.clear();
+			expect( hashBuffer( longSilence ) != hashBuffer( shortSilence ) );
+
+			// rate dependent results of equal samples differ by rate
+			expect( combineWithSampleRate( hashBuffer( b ), 44100. ) != combineWithSampleRate( hashBuffer( b ), 48000. ) );
+			expect( combineWithSampleRate( 0, 44100. ) == 0 );
+		}
+
+		void testCompareBuffer()
+		{
+			beginTest( "testCompareBuffer" );
+
+			AudioBuffer<float> b( 2, 16 );
+			b.clear();
+			AudioBuffer<float> copy( b );
+			expect( compareBuffer( b, copy ) );
+			copy.setSample( 1, 15, 1.f );
+			expect( !compareBuffer( b, copy ) );
+			expect( !compareBuffer( b, AudioBuffer<float>( 2, 8 ) ) );
+		}
+	};
+	static AudioHashTest audioHashTest;
+}
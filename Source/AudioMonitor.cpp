@@ -0,0 +1,110 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioMonitor.h"
+
+using namespace aud;
+
+// CallbackMonitor
+aud::CallbackMonitor::CallbackMonitor( std::initializer_list<AudioIODeviceCallback*> callbacks_ ) :
+	callbacks( callbacks_ )
+{}
+
+aud::CallbackMonitor::Stats aud::CallbackMonitor::popStats()
+{
+	Stats ret;
+	ret.load = load.load();
+	ret.worstMs = worstMs.exchange( 0. );
+
+	// devices that cannot report xruns are judged by callback timing
+	const auto deviceXRuns = numDeviceXRuns.load();
+	ret.numXRuns = deviceXRuns >= 0 ? deviceXRuns : numLateCallbacks.load();
+	for( int i = 0; i < NumBins; ++i ){
+		ret.histogram[ i ] = histogram[ i ].load();
+	}
+	return ret;
+}
+
+// CallbackMonitor - AudioIODeviceCallback
+void aud::CallbackMonitor::audioDeviceIOCallback( const float** inputChannelData, int numInputChannels, float** outputChannelData, int numOutputChannels, int numSamples )
+{
+	const auto start = Time::getHighResolutionTicks();
+	processCallbacks( inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples );
+	const auto end = Time::getHighResolutionTicks();
+	if( sampleRate <= 0. || numSamples <= 0 ){
+		return;
+	}
+	// time used of the buffer duration
+	const auto bufferSeconds = numSamples / sampleRate;
+	const auto seconds = Time::highResolutionTicksToSeconds( end - start );
+	const auto used = ( float )( seconds / bufferSeconds );
+	load.store( load.load( std::memory_order_relaxed ) * 0.9f + used * 0.1f, std::memory_order_relaxed );
+	if( seconds * 1000. > worstMs.load( std::memory_order_relaxed ) ){
+		worstMs.store( seconds * 1000., std::memory_order_relaxed );
+	}
+	histogram[ jmin( NumBins - 1, ( int )( used * 10.f ) ) ].fetch_add( 1, std::memory_order_relaxed );
+
+	// a callback arriving much later than one buffer after the last one means output was missed
+	if( lastCallbackTicks > 0 && Time::highResolutionTicksToSeconds( start - lastCallbackTicks ) > bufferSeconds * 1.5 ){
+		numLateCallbacks.fetch_add( 1, std::memory_order_relaxed );
+	}
+	lastCallbackTicks = start;
+	if( device != nullptr ){
+		numDeviceXRuns.store( device->getXRunCount(), std::memory_order_relaxed );
+	}
+}
+
+void aud::CallbackMonitor::audioDeviceAboutToStart( AudioIODevice* newDevice )
+{
+	device = newDevice;
+	sampleRate = newDevice->getCurrentSampleRate();
+	lastCallbackTicks = 0;
+	scratch.setSize( newDevice->getActiveOutputChannels().countNumberOfSetBits(), jmax( 1, newDevice->getCurrentBufferSizeSamples() ) );
+	numInputs = newDevice->getActiveInputChannels().countNumberOfSetBits();
+	inputs.malloc( numInputs + 1 );
+	for( auto* c : callbacks ){
+		c->audioDeviceAboutToStart( newDevice );
+	}
+}
+
+void aud::CallbackMonitor::audioDeviceStopped()
+{
+	for( auto* c : callbacks ){
+		c->audioDeviceStopped();
+	}
+	device = nullptr;
+}
+
+void aud::CallbackMonitor::audioDeviceError( const String& errorMessage )
+{
+	for( auto* c : callbacks ){
+		c->audioDeviceError( errorMessage );
+	}
+}
+
+// CallbackMonitor - process
+void aud::CallbackMonitor::processCallbacks( const float** inputChannelData, int numInputChannels, float** outputChannelData, int numOutputChannels, int numSamples )
+{
+	if( callbacks.empty() ){
+		return;
+	}
+	callbacks.front()->audioDeviceIOCallback( inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples );
+	if( callbacks.size() == 1 ){
+		return;
+	}
+	// the others in chunks of the scratch size
+	const auto numChans = jmin( numOutputChannels, scratch.getNumChannels() );
+	const auto numIns = jmin( numInputChannels, numInputs );
+	for( int pos = 0; pos < numSamples; pos += scratch.getNumSamples() ){
+		const auto len = jmin( scratch.getNumSamples(), numSamples - pos );
+		for( int ch = 0; ch < numIns; ++ch ){
+			inputs[ ch ] = inputChannelData[ ch ] + pos;
+		}
+		for( size_t i = 1; i < callbacks.size(); ++i ){
+			callbacks[ i ]->audioDeviceIOCallback( inputs, numIns, scratch.getArrayOfWritePointers(), numChans, len );
+			for( int ch = 0; ch < numChans; ++ch ){
+				if( outputChannelData[ ch ] != nullptr ){
+					FloatVectorOperations::add( outputChannelData[ ch ] + pos, scratch.getReadPointer( ch ), len );
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+namespace aud
+{
+	/// Measures the cost of wrapped device callbacks, their outputs are mixed. The audio thread only writes atomics,
+	/// any other thread reads them without blocking it.
+	class CallbackMonitor : public AudioIODeviceCallback
+	{
+	public:
+		/// Histogram bins of callback time in tenths of the buffer duration, the last bin is overload.
+		static const int NumBins = 11;
+
+		CallbackMonitor( std::initializer_list<AudioIODeviceCallback*> callbacks );
+
+		struct Stats
+		{
+			float load = 0.f; // smoothed, 1 is the whole buffer duration
+			double worstMs = 0.;
+			int numXRuns = 0;
+			std::array<int64, NumBins> histogram{};
+		};
+
+		/// Reads the current stats, the worst time is reset with each call.
+		Stats popStats();
+
+		// AudioIODeviceCallback
+		void audioDeviceIOCallback( const float** inputChannelData, int numInputChannels, float** outputChannelData, int numOutputChannels, int numSamples )override;
+		void audioDeviceAboutToStart( AudioIODevice* device )override;
+		void audioDeviceStopped()override;
+		void audioDeviceError( const String& errorMessage )override;
+
+	private:
+		// process
+		/// Calls all callbacks, each after the first renders into scratch, which is then added.
+		void processCallbacks( const float** inputChannelData, int numInputChannels, float** outputChannelData, int numOutputChannels, int numSamples );
+
+		std::vector<AudioIODeviceCallback*> callbacks;
+		AudioBuffer<float> scratch; // allocated before the device starts
+		HeapBlock<const float*> inputs;
+		int numInputs = 0;
+		AudioIODevice* device = nullptr; // only used on the audio thread
+		double sampleRate = 0.;
+		int64 lastCallbackTicks = 0;
+
+		std::atomic<float> load{ 0.f };
+		std::atomic<double> worstMs{ 0. };
+		std::atomic<int> numDeviceXRuns{ -1 };
+		std::atomic<int> numLateCallbacks{ 0 };
+		std::array<std::atomic<int64>, NumBins> histogram{};
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( CallbackMonitor );
+	};
+}
@@ -0,0 +1,356 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioOutput.h"
+
+using namespace aud;
+
+// dither and noise shaping round the same for any thread count or vector width
+UNC_DETERMINISTIC_FLOAT
+
+// createAudioFormat
+std::unique_ptr<AudioFormat> aud::createAudioFormat( FileFormat format )
+{
+	switch( format ){
+		case FileFormat::Wav: return std::unique_ptr<AudioFormat>( new WavAudioFormat() );
+		case FileFormat::Aiff: return std::unique_ptr<AudioFormat>( new AiffAudioFormat() );
+#if JUCE_USE_FLAC
+		case FileFormat::Flac: return std::unique_ptr<AudioFormat>( new FlacAudioFormat() );
+#endif
+		default: return nullptr;
+	}
+}
+
+// OutputFormat - access
+int aud::OutputFormat::getSupportedBitsPerSample() const
+{
+	auto audioFormat = createAudioFormat( format );
+	if( audioFormat == nullptr ){
+		return bitsPerSample;
+	}
+	int ret = 0;
+	for( auto depth : audioFormat->getPossibleBitDepths() ){
+		if( depth <= bitsPerSample ){
+			ret = jmax( ret, depth );
+		}
+	}
+	return ret > 0 ? ret : bitsPerSample;
+}
+
+String aud::OutputFormat::getFileExtension() const
+{
+	switch( format ){
+		case FileFormat::Aiff: return "aif";
+		case FileFormat::Flac: return "flac";
+		default: return "wav";
+	}
+}
+
+// createWriterMetadata
+StringPairArray aud::createWriterMetadata( const SampleMetadata& sample, double sampleRate, FileFormat format )
+{
+	StringPairArray ret;
+	if( format != FileFormat::Wav ){
+		return ret;
+	}
+	// smpl chunk, sample period in nanoseconds
+	ret.set( "SamplePeriod", String( roundToInt( 1.e9 / sampleRate ) ) );
+	if( sample.rootNote >= 0 ){
+		ret.set( "MidiUnityNote", String( sample.rootNote ) );
+	}
+	if( sample.isLooping() ){
+		ret.set( "NumSampleLoops", "1" );
+		ret.set( "Loop0Identifier", "1" );
+		ret.set( "Loop0Type", "0" );
+		ret.set( "Loop0Start", String( sample.loopStart ) );
+		ret.set( "Loop0End", String( sample.loopEnd ) );
+	}
+	// cue point the loop refers to, at its start or the first sample, labelled with the name, and the name as list info
+	if( sample.name.isNotEmpty() ){
+		ret.set( "NumCuePoints", "1" );
+		ret.set( "Cue0Identifier", "1" );
+		ret.set( "Cue0Offset", String( sample.isLooping() ? sample.loopStart : 0 ) );
+		ret.set( "NumCueLabels", "1" );
+		ret.set( "CueLabel0Identifier", "1" );
+		ret.set( "CueLabel0Text", sample.name );
+		ret.set( "INAM", sample.name );
+	}
+	return ret;
+}
+
+// quantize
+void aud::quantize( const AudioBuffer<float>& source, int startSample, int numSamples, int* const* dest, int bitsPerSample, bool dither, bool noiseShaping, Random& random, float* errors )
+{
+	// integer steps of the target depth, shifted into the upper bits for the writer
+	const auto scale = ( float )( 1 << ( bitsPerSample - 1 ) );
+	const auto shift = 1 << ( 32 - bitsPerSample );
+	HeapBlock<float> scaled( numSamples );
+	HeapBlock<float> noise( numSamples );
+	for( int ch = 0; ch < source.getNumChannels(); ++ch ){
+		// triangular noise of +-1 step
+		if( dither ){
+			for( int i = 0; i < numSamples; ++i ){
+				noise[ i ] = random.nextFloat() - random.nextFloat();
+			}
+		}
+		else{
+			FloatVectorOperations::clear( noise, numSamples );
+		}
+		FloatVectorOperations::copyWithMultiply( scaled, source.getReadPointer( ch, startSample ), scale, numSamples );
+
+		// first order error feedback pushes the noise up in frequency, runs per sample
+		if( noiseShaping ){
+			auto error = errors[ ch ];
+			for( int i = 0; i < numSamples; ++i ){
+				const auto value = scaled[ i ] - error;
+				const auto q = jlimit( -scale, scale - 1.f, ( float )roundToInt( value + noise[ i ] ) );
+				error = q - value;
+				scaled[ i ] = q;
+			}
+			errors[ ch ] = error;
+		}
+		else{
+			FloatVectorOperations::add( scaled, noise, numSamples );
+			FloatVectorOperations::clip( scaled, scaled, -scale, scale - 1.f, numSamples );
+		}
+		auto* out = dest[ ch ];
+		for( int i = 0; i < numSamples; ++i ){
+			out[ i ] = roundToInt( scaled[ i ] ) * shift;
+		}
+	}
+}
+
+// QueuedWriter
+aud::QueuedWriter::QueuedWriter( AudioFormatWriter* writer_, TimeSliceThread& thread_, int blockLength_ ) :
+	writer( writer_ ),
+	thread( thread_ ),
+	blockLength( blockLength_ ),
+	numChannels( ( int )writer_->getNumChannels() ),
+	channels( numChannels + 1, true ) // null terminated
+{
+	for( auto& block : blocks ){
+		block.samples.malloc( blockLength * numChannels );
+	}
+	thread.addTimeSliceClient( this );
+}
+
+aud::QueuedWriter::~QueuedWriter()
+{
+	flush();
+	thread.removeTimeSliceClient( this );
+}
+
+// QueuedWriter - modify
+bool aud::QueuedWriter::write( const int* const* data, int numSamples )
+{
+	jassert( numSamples <= blockLength );
+
+	// back pressure, wait for the disk
+	while( fifo.getFreeSpace() == 0 && !failed ){
+		thread.notify();
+		blockWritten.wait( 100 );
+	}
+	if( failed ){
+		return false;
+	}
+	int start1, size1, start2, size2;
+	fifo.prepareToWrite( 1, start1, size1, start2, size2 );
+	auto& block = blocks[ start1 ];
+	for( int ch = 0; ch < numChannels; ++ch ){
+		memcpy( block.samples + ch * blockLength, data[ ch ], sizeof( int ) * ( size_t )numSamples );
+	}
+	block.numSamples = numSamples;
+	fifo.finishedWrite( 1 );
+	thread.notify();
+	return true;
+}
+
+bool aud::QueuedWriter::flush()
+{
+	while( fifo.getNumReady() > 0 && !failed ){
+		thread.notify();
+		blockWritten.wait( 100 );
+	}
+	return !failed && writer->flush();
+}
+
+int aud::QueuedWriter::useTimeSlice()
+{
+	UNC_TRACE_JOB( -1 );
+	while( fifo.getNumReady() > 0 ){
+		int start1, size1, start2, size2;
+		fifo.prepareToRead( 1, start1, size1, start2, size2 );
+		auto& block = blocks[ start1 ];
+		for( int ch = 0; ch < numChannels; ++ch ){
+			channels[ ch ] = block.samples + ch * blockLength;
+		}
+		if( !failed ){
+			UNC_TRACE_SCOPE( "disk" );
+			UNC_TRACE_BYTES( "written", ( int64 )block.numSamples * numChannels * writer->getBitsPerSample() / 8 );
+			failed = !writer->write( channels, block.numSamples );
+		}
+		fifo.finishedRead( 1 );
+		blockWritten.signal();
+	}
+	return 10;
+}
+
+// syncToDisk
+bool aud::syncToDisk( const File& file )
+{
+	// juce's flush also syncs the file, opening it appends and keeps its content
+	FileOutputStream fos( file );
+	if( fos.failedToOpen() ){
+		return false;
+	}
+	fos.flush();
+	return fos.getStatus().wasOk();
+}
+
+// removeTemporaryFiles
+int aud::removeTemporaryFiles( const Array<File>& targets )
+{
+	// juce's TemporaryFile names them after the target, with "_temp" and a hex number
+	int ret = 0;
+	std::map<File, Array<File>> targetsInDir;
+	for( const auto& target : targets ){
+		targetsInDir[ target.getParentDirectory() ].addIfNotAlreadyThere( target );
+	}
+	for( const auto& dir : targetsInDir ){
+		for( const auto& file : dir.first.findChildFiles( File::findFiles, false, "*_temp*" ) ){
+			for( const auto& target : dir.second ){
+				const auto prefix = target.getFileNameWithoutExtension() + "_temp";
+				const auto name = file.getFileNameWithoutExtension();
+				if( file.hasFileExtension( target.getFileExtension() ) && name.startsWith( prefix ) && name.length() > prefix.length()
+					&& name.substring( prefix.length() ).containsOnly( "0123456789abcdef" ) ){
+					ret += file.deleteFile() ? 1 : 0;
+					break;
+				}
+			}
+		}
+	}
+	return ret;
+}
+
+// writeToFile
+/// Encodes audio in blocks for writer and passes each to write, until it returns false.
+/// Integer depths are quantized here so dither is not lost in the writer's conversion, float is passed as is.
+bool encodeBlocks( const AudioBuffer<float>& audio, const AudioFormatWriter& writer, const OutputFormat& format, Random& random, const std::function<bool( const int**, int )>& write )
+{
+	const auto bits = ( int )writer.getBitsPerSample();
+	const auto isFloat = writer.isFloatingPoint() || bits >= 32;
+	const auto numChans = audio.getNumChannels();
+	HeapBlock<int> samples( OutputBlockLength * numChans );
+	HeapBlock<int*> channels( numChans + 1, true ); // null terminated
+	for( int ch = 0; ch < numChans; ++ch ){
+		channels[ ch ] = samples + ch * OutputBlockLength;
+	}
+	HeapBlock<float> errors( numChans, true );
+
+	for( int pos = 0; pos < audio.getNumSamples(); pos += OutputBlockLength ){
+		const auto len = jmin( OutputBlockLength, audio.getNumSamples() - pos );
+		UNC_TRACE_SCOPE( "encode" );
+		if( isFloat ){
+			for( int ch = 0; ch < numChans; ++ch ){
+				memcpy( channels[ ch ], audio.getReadPointer( ch, pos ), sizeof( float ) * ( size_t )len );
+			}
+		}
+		else{
+			quantize( audio, pos, len, channels, bits, format.dither, format.noiseShaping, random, errors );
+		}
+		if( !write( const_cast<const int**>( channels.get() ), len ) ){
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Encodes audio into a new file, the writer and its stream are closed on return.
+bool encodeToFile( const File& file, AudioFormat& audioFormat, const AudioBuffer<float>& audio, double sampleRate, const OutputFormat& format, const StringPairArray& metadata, Random& random, TimeSliceThread* ioThread )
+{
+	std::unique_ptr<FileOutputStream> fos( file.createOutputStream() );
+	if( fos == nullptr ){
+		return false;
+	}
+	// writer owns fos once created, flac at its default compression
+	const auto quality = format.format == FileFormat::Flac ? 5 : 0;
+	std::unique_ptr<AudioFormatWriter> writer( audioFormat.createWriterFor( fos.get(), sampleRate, audio.getNumChannels(), format.getSupportedBitsPerSample(), metadata, quality ) );
+	if( writer == nullptr ){
+		return false;
+	}
+	fos.release();
+
+	if( ioThread == nullptr ){
+		return encodeBlocks( audio, *writer, format, random, [ & ]( const int** data, int numSamples ){
+			UNC_TRACE_SCOPE( "disk" );
+			UNC_TRACE_BYTES( "written", ( int64 )numSamples * audio.getNumChannels() * writer->getBitsPerSample() / 8 );
+			return writer->write( data, numSamples );
+		} );
+	}
+	auto& encoding = *writer;
+	QueuedWriter queued( writer.release(), *ioThread, OutputBlockLength );
+	return encodeBlocks( audio, encoding, format, random, [ & ]( const int** data, int numSamples ){
+		return queued.write( data, numSamples );
+	} ) && queued.flush();
+}
+
+bool aud::writeToFile( const File& targetFile, const AudioBuffer<float>& audio, double sampleRate, const OutputFormat& format, TimeSliceThread* ioThread, const StringPairArray& metadata )
+{
+	auto audioFormat = createAudioFormat( format.format );
+	if( audioFormat == nullptr ){
+		jassertfalse;
+		return false;
+	}
+	// encode next to the target, which is replaced by rename only once the file is complete
+	auto file = targetFile.withFileExtension( format.getFileExtension() );
+	TemporaryFile temp( file );
+
+	// dither is seeded by name, so a file renders the same every time
+	Random random( file.getFileName().hashCode64() );
+	if( !encodeToFile( temp.getFile(), *audioFormat, audio, sampleRate, format, metadata, random, ioThread ) ){
+		return false;
+	}
+	// on disk before the rename, so a crash never leaves a complete name over missing content
+	return syncToDisk( temp.getFile() ) && temp.overwriteTargetFileWithTemporary();
+}
+
+// FileAppender
+aud::FileAppender::FileAppender( const File& targetFile, int numChannels, double sampleRate, const OutputFormat& format_, const StringPairArray& metadata ) :
+	file( targetFile.withFileExtension( format_.getFileExtension() ) ),
+	temp( file ),
+	format( format_ ),
+	random( file.getFileName().hashCode64() )
+{
+	auto audioFormat = createAudioFormat( format.format );
+	std::unique_ptr<FileOutputStream> fos( temp.getFile().createOutputStream() );
+	if( audioFormat == nullptr || fos == nullptr ){
+		failed = true;
+		return;
+	}
+	const auto quality = format.format == FileFormat::Flac ? 5 : 0;
+	writer.reset( audioFormat->createWriterFor( fos.get(), sampleRate, ( unsigned int )numChannels, format.getSupportedBitsPerSample(), metadata, quality ) );
+	if( writer == nullptr ){
+		failed = true;
+		return;
+	}
+	fos.release();
+}
+
+bool aud::FileAppender::append( const AudioBuffer<float>& audio )
+{
+	if( failed || audio.getNumChannels() != ( int )writer->getNumChannels() ){
+		failed = true;
+		return false;
+	}
+	failed = !encodeBlocks( audio, *writer, format, random, [ & ]( const int** data, int num ){
+		UNC_TRACE_SCOPE( "disk" );
+		return writer->write( data, num );
+	} );
+	numSamples += audio.getNumSamples();
+	return !failed;
+}
+
+bool aud::FileAppender::finish()
+{
+	// the writer completes the header when deleted
+	writer.reset();
+	return !failed && syncToDisk( temp.getFile() ) && temp.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include "Trace.h"
+
+namespace aud
+{
+	/// File formats audio can be rendered to.
+	enum class FileFormat
+	{
+		Wav, Aiff, Flac, NumFormats
+	};
+
+	inline String toString( FileFormat format )
+	{
+		switch( format ){
+			case FileFormat::Wav: return "WAV";
+			case FileFormat::Aiff: return "AIFF";
+			case FileFormat::Flac: return "FLAC";
+			default: return "Invalid";
+		}
+	}
+
+	/// \returns a new instance of the juce format for format, nullptr if not compiled in.
+	std::unique_ptr<AudioFormat> createAudioFormat( FileFormat format );
+
+	/// How rendered audio is encoded.
+	struct OutputFormat
+	{
+		FileFormat format = FileFormat::Wav;
+
+		/// 16 or 24 bit integer, 32 is float if the format supports it.
+		int bitsPerSample = 24;
+
+		/// TPDF dither when reducing to integer, optionally with first order noise shaping.
+		bool dither = true;
+		bool noiseShaping = false;
+
+		// access
+		/// \returns bitsPerSample, or the highest depth below it the format can write.
+		int getSupportedBitsPerSample() const;
+		String getFileExtension() const;
+	};
+
+	/// Name, root note and loop of a rendered sample, so samplers can map and loop it without analysis.
+	struct SampleMetadata
+	{
+		String name;
+
+		/// Midi note the sample sounds at, -1 if unknown.
+		int rootNote = -1;
+
+		/// First and last sample of the loop, none if loopEnd is before loopStart.
+		int64 loopStart = 0;
+		int64 loopEnd = -1;
+
+		// access
+		bool isLooping() const{ return loopEnd >= loopStart; }
+	};
+
+	/// \returns metadata as read by the juce writer of format, the wav writer turns it into smpl, cue and list chunks.
+	/// Other formats expect their own keys and get none.
+	StringPairArray createWriterMetadata( const SampleMetadata& sample, double sampleRate, FileFormat format );
+
+	/// Samples per channel encoded and written at once.
+	const static int OutputBlockLength( 16384 );
+
+	/// Quantizes float audio to left justified 32 bit integers of bitsPerSample resolution.
+	/// \param errors holds the noise shaping state per channel, must be of size numChannels.
+	void quantize( const AudioBuffer<float>& source, int startSample, int numSamples, int* const* dest, int bitsPerSample, bool dither, bool noiseShaping, Random& random, float* errors );
+
+	/// Like AudioFormatWriter::ThreadedWriter, but queues blocks in the writer's own sample format,
+	/// so quantized and dithered data is written as is. Two blocks are in flight, write() waits while both are queued.
+	class QueuedWriter : private TimeSliceClient
+	{
+	public:
+		/// Takes ownership of writer, blocks are written on thread.
+		QueuedWriter( AudioFormatWriter* writer, TimeSliceThread& thread, int blockLength );
+		~QueuedWriter();
+
+		// modify
+		/// Copies numSamples, no more than the block length, into the queue. Data is float for floating point writers.
+		/// \returns false if the writer failed.
+		bool write( const int* const* data, int numSamples );
+
+		/// Waits until all queued blocks are written.
+		/// \returns false if the writer failed.
+		bool flush();
+
+	private:
+		int useTimeSlice() override;
+
+		struct Block
+		{
+			HeapBlock<int> samples;
+			int numSamples = 0;
+		};
+		std::unique_ptr<AudioFormatWriter> writer;
+		TimeSliceThread& thread;
+		const int blockLength;
+		const int numChannels;
+		std::array<Block, 3> blocks; // the fifo keeps one slot free
+		AbstractFifo fifo{ 3 };
+		HeapBlock<const int*> channels;
+		WaitableEvent blockWritten;
+		std::atomic<bool> failed{ false };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( QueuedWriter );
+	};
+
+	/// Forces everything written to file onto the disk, so a rename never exposes content the system has not stored yet.
+	/// \returns true if successful.
+	bool syncToDisk( const File& file );
+
+	/// Deletes the temporary files writeToFile() and FileAppender leave next to any of targets when interrupted.
+	/// \returns number of files deleted.
+	int removeTemporaryFiles( const Array<File>& targets );
+
+	/// Encodes audio with format and writes it, replacing targetFile, the extension is set by the format.
+	/// The file is written under a temporary name first, synced to disk and renamed once complete, so targetFile is never partly written.
+	/// \param ioThread if given, disk writes are queued there while encoding continues.
+	/// \param metadata is written into the header, see createWriterMetadata().
+	/// \returns true if successful.
+	bool writeToFile( const File& targetFile, const AudioBuffer<float>& audio, double sampleRate, const OutputFormat& format, TimeSliceThread* ioThread = nullptr, const StringPairArray& metadata = StringPairArray() );
+
+	/// Encodes consecutive buffers into one large file, which replaces targetFile once finished, like writeToFile().
+	class FileAppender
+	{
+	public:
+		/// \param metadata is written into the header, e.g. cue points, if the format supports it.
+		FileAppender( const File& targetFile, int numChannels, double sampleRate, const OutputFormat& format, const StringPairArray& metadata = StringPairArray() );
+
+		// modify
+		/// Encodes audio after everything appended before, it must have the channel count of the file.
+		/// \returns false if the file failed.
+		bool append( const AudioBuffer<float>& audio );
+
+		/// Closes the file, syncs it to disk and moves it over targetFile.
+		/// \returns false if any step failed.
+		bool finish();
+
+		// access
+		int64 getNumSamples() const{ return numSamples; }
+
+	private:
+		File file;
+		TemporaryFile temp;
+		OutputFormat format;
+		std::unique_ptr<AudioFormatWriter> writer;
+		Random random;
+		int64 numSamples = 0;
+		bool failed = false;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( FileAppender );
+	};
+}
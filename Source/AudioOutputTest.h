@@ -0,0 +1,145 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "AudioOutput.h"
+
+namespace aud
+{
+	class AudioOutputTest : public UnitTest
+	{
+	public:
+		AudioOutputTest() : UnitTest( "AudioOutputTest" ){}
+
+		void runTest() override
+		{
+			testQuantize();
+			testBitDepths();
+			testQueuedWriter();
+			testTemporaryFiles();
+		}
+
+		void testQuantize()
+		{
+			beginTest( "testQuantize" );
+
+			AudioBuffer<float> b( 1, 4 );
+			b.setSample( 0, 0, 0.f );
+			b.setSample( 0, 1, 0.5f );
+			b.setSample( 0, 2, -1.f );
+			b.setSample( 0, 3, 1.f );
+			int samples[ 4 ];
+			int* dest[] = { samples };
+			float errors[] = { 0.f };
+			Random random( 1 );
+
+			// without dither values land on 16 bit steps, full scale is clipped
+			quantize( b, 0, 4, dest, 16, false, false, random, errors );
+			expectEquals( samples[ 0 ], 0 );
+			expectEquals( samples[ 1 ], 16384 << 16 );
+			expectEquals( samples[ 2 ], -32768 * 65536 );
+			expectEquals( samples[ 3 ], 32767 << 16 );
+
+			// dither stays within one step
+			AudioBuffer<float> c( 1, 1000 );
+			c.clear();
+			HeapBlock<int> dithered( 1000 );
+			int* ditheredDest[] = { dithered };
+			quantize( c, 0, 1000, ditheredDest, 16, true, false, random, errors );
+			bool isNoisy = false;
+			for( int i = 0; i < 1000; ++i ){
+				expect( std::abs( dithered[ i ] >> 16 ) <= 1 );
+				isNoisy |= dithered[ i ] != 0;
+			}
+			expect( isNoisy );
+
+			// shaped error feedback keeps the mean of a constant
+			for( int i = 0; i < 1000; ++i ){
+				c.setSample( 0, i, 0.25f / 32768.f );
+			}
+			quantize( c, 0, 1000, ditheredDest, 16, true, true, random, errors );
+			double mean = 0.;
+			for( int i = 0; i < 1000; ++i ){
+				mean += ( dithered[ i ] >> 16 ) / 1000.;
+			}
+			expectWithinAbsoluteError( mean, 0.25, 0.05 );
+		}
+
+		void testBitDepths()
+		{
+			beginTest( "testBitDepths" );
+
+			OutputFormat f;
+			f.bitsPerSample = 32;
+			expectEquals( f.getSupportedBitsPerSample(), 32 );
+			expectEquals( f.getFileExtension(), String( "wav" ) );
+
+			// formats without float fall back to 24 bit
+			f.format = FileFormat::Aiff;
+			expectEquals( f.getSupportedBitsPerSample(), 24 );
+			f.format = FileFormat::Flac;
+			expectEquals( f.getSupportedBitsPerSample(), 24 );
+			f.bitsPerSample = 16;
+			expectEquals( f.getSupportedBitsPerSample(), 16 );
+		}
+
+		void testQueuedWriter()
+		{
+			beginTest( "testQueuedWriter" );
+
+			// more blocks than the queue holds, 16 bit wav in memory
+			MemoryBlock data;
+			TimeSliceThread thread( "testQueuedWriter" );
+			thread.startThread();
+			{
+				auto* writer = WavAudioFormat().createWriterFor( new MemoryOutputStream( data, false ), 44100., 1, 16, StringPairArray(), 0 );
+				QueuedWriter queued( writer, thread, 100 );
+				int samples[ 100 ];
+				const int* channels[] = { samples, nullptr };
+				for( int block = 0; block < 5; ++block ){
+					for( int i = 0; i < 100; ++i ){
+						samples[ i ] = ( block * 100 + i ) << 16;
+					}
+					expect( queued.write( channels, 100 ) );
+				}
+				expect( queued.flush() );
+			}
+			// read back in order
+			std::unique_ptr<AudioFormatReader> reader( WavAudioFormat().createReaderFor( new MemoryInputStream( data, false ), true ) );
+			expect( reader != nullptr );
+			expectEquals( ( int )reader->lengthInSamples, 500 );
+			AudioBuffer<float> b( 1, 500 );
+			reader->read( &b, 0, 500, 0, true, false );
+			expectEquals( roundToInt( b.getSample( 0, 499 ) * 32768.f ), 499 );
+			expectEquals( roundToInt( b.getSample( 0, 250 ) * 32768.f ), 250 );
+		}
+
+		void testTemporaryFiles()
+		{
+			beginTest( "testTemporaryFiles" );
+
+			// leftovers of the target go, similar names stay
+			const auto dir = File::createTempFile( "testTemporaryFiles" );
+			expect( dir.createDirectory().wasOk() );
+			const auto target = dir.getChildFile( "a.wav" );
+			const auto leftover = TemporaryFile( target ).getFile();
+			const auto others = { dir.getChildFile( "a_tempo.wav" ), dir.getChildFile( "a_temp1f.flac" ), dir.getChildFile( "b_temp1f.wav" ) };
+			expect( leftover.create().wasOk() );
+			for( const auto& other : others ){
+				expect( other.create().wasOk() );
+			}
+			expectEquals( removeTemporaryFiles( { target } ), 1 );
+			expect( !leftover.exists() );
+			for( const auto& other : others ){
+				expect( other.existsAsFile() );
+			}
+
+			// synced files keep their content
+			expect( target.replaceWithText( "abc" ) );
+			expect( syncToDisk( target ) );
+			expectEquals( target.loadFileAsString(), String( "abc" ) );
+			expect( !syncToDisk( dir.getChildFile( "missing" ).getChildFile( "a.wav" ) ) );
+			dir.deleteRecursively();
+		}
+	};
+	static AudioOutputTest audioOutputTest;
+}
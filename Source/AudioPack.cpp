@@ -0,0 +1,209 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioPack.h"
+
+#include "AudioSampler.h"
+
+using namespace unc;
+
+// jobs rendered ahead of the writer per worker, bounds memory while all cores render
+const static int PackJobsPerWorker( 4 );
+// sample loops juce writes into a wav header, the sfz maps all of them
+const static int MaxPackLoops( 64 );
+// regions of one sfz, one per key from the first note of the sampler up
+const static int MaxSfzRegions( 128 - KeyMap::FirstNote );
+
+// createSfz
+String unc::createSfz( const std::vector<PackRegion>& regions, const File& sfzFile )
+{
+	String ret;
+	ret << "// " << sfzFile.getFileNameWithoutExtension() << ", " << ( int )regions.size() << " regions" << newLine;
+	String group;
+	for( size_t i = 0; i < regions.size(); ++i ){
+		const auto& region = regions[ i ];
+		if( i == 0 || region.group != group ){
+			group = region.group;
+			ret << newLine << "<group> // " << group << newLine;
+		}
+		// end and loop end are the last sample played
+		const auto end = region.offset + region.length - 1;
+		ret << "// " << region.name << newLine;
+		ret << "<region> sample=" << region.file.getRelativePathFrom( sfzFile.getParentDirectory() ).replaceCharacter( '\\', '/' )
+			<< " offset=" << region.offset << " end=" << end;
+		// samplers play regions without a key on every key
+		jassert( isPositiveAndBelow( region.key, 128 ) );
+		ret << " key=" << region.key << " pitch_keycenter=" << ( region.rootNote >= 0 ? region.rootNote : region.key );
+		if( region.isLooping ){
+			ret << " loop_mode=loop_continuous loop_start=" << region.offset + region.loopStart << " loop_end=" << end;
+		}
+		else{
+			ret << " loop_mode=one_shot";
+		}
+		ret << newLine;
+	}
+	return ret;
+}
+
+// getSfzFiles
+Array<File> unc::getSfzFiles( const File& sfzFile, int numRegions )
+{
+	Array<File> ret{ sfzFile };
+	for( int i = 1; i * MaxSfzRegions < numRegions; ++i ){
+		ret.add( sfzFile.getSiblingFile( sfzFile.getFileNameWithoutExtension() + "_" + String( i + 1 ) ).withFileExtension( sfzFile.getFileExtension() ) );
+	}
+	return ret;
+}
+
+// renderPack
+/// Jobs of one sample rate and channel count, appended into one file.
+struct Pack
+{
+	double sampleRate;
+	int numChannels;
+	File file;
+	std::vector<size_t> jobs;
+	int64 length = 0;
+};
+
+/// Cue point and label of every region, and a sample loop of every looping one, as read by juce's wav writer.
+StringPairArray createPackMetadata( const std::vector<PackRegion>& regions, const Pack& pack )
+{
+	StringPairArray ret;
+	int numLoops = 0;
+	for( size_t i = 0; i < pack.jobs.size(); ++i ){
+		const auto& region = regions[ pack.jobs[ i ] ];
+		const auto cue = "Cue" + String( ( int )i );
+		ret.set( cue + "Identifier", String( ( int )i + 1 ) );
+		ret.set( cue + "Offset", String( region.offset ) );
+		const auto label = "CueLabel" + String( ( int )i );
+		ret.set( label + "Identifier", String( ( int )i + 1 ) );
+		ret.set( label + "Text", region.group + "/" + region.name );
+		if( region.isLooping && numLoops < MaxPackLoops ){
+			const auto loop = "Loop" + String( numLoops++ );
+			ret.set( loop + "Identifier", String( ( int )i + 1 ) );
+			ret.set( loop + "Type", "0" );
+			ret.set( loop + "Start", String( region.offset + region.loopStart ) );
+			ret.set( loop + "End", String( region.offset + region.length - 1 ) );
+		}
+	}
+	ret.set( "NumCuePoints", String( ( int )pack.jobs.size() ) );
+	ret.set( "NumCueLabels", String( ( int )pack.jobs.size() ) );
+	if( numLoops > 0 ){
+		ret.set( "NumSampleLoops", String( numLoops ) );
+	}
+	return ret;
+}
+
+Result unc::renderPack( const RenderJobs& jobs, const RenderSettings& settings, const File& sfzFile )
+{
+	clearTrace();
+	const auto extension = settings.output.getFileExtension();
+
+	// regions follow each other in job order, their offsets are known before rendering
+	std::vector<Pack> packs;
+	std::vector<PackRegion> regions( jobs.size() );
+	for( size_t i = 0; i < jobs.size(); ++i ){
+		const auto& job = jobs[ i ];
+		const auto zone = job.clip->getZone( job.zoneIndex );
+		const auto numChannels = jmin( job.clip->getNumChannels(), ( int )aud::MaxNumAudioChannels );
+		auto pack = std::find_if( packs.begin(), packs.end(), [ & ]( const Pack& p ){
+			return p.sampleRate == job.clip->sampleRate && p.numChannels == numChannels;
+		} );
+		if( pack == packs.end() ){
+			packs.push_back( { job.clip->sampleRate, numChannels, File(), {} } );
+			pack = packs.end() - 1;
+		}
+		auto& region = regions[ i ];
+		region.name = job.target.getFileNameWithoutExtension();
+		region.group = job.clip->getName();
+		region.offset = pack->length;
+		region.length = zone.getRenderedLength( settings.isLoopBaked );
+		region.isLooping = zone.mode == AudioPlayMode::Loop;
+		region.loopStart = region.isLooping ? zone.getRenderedLoopStart( settings.isLoopBaked ) : 0;
+		// a key of its own for every region in its sfz, so zones never overlap
+		region.key = KeyMap::FirstNote + ( int )i % MaxSfzRegions;
+		region.rootNote = job.clip->pitch.hasRootNote() ? job.clip->pitch.getRootNote() : -1;
+		pack->jobs.push_back( i );
+		pack->length += region.length;
+	}
+	for( size_t p = 0; p < packs.size(); ++p ){
+		const auto name = sfzFile.getFileNameWithoutExtension() + ( packs.size() > 1 ? "_" + String( ( int )p + 1 ) : String() );
+		packs[ p ].file = sfzFile.getSiblingFile( name ).withFileExtension( extension );
+		for( auto i : packs[ p ].jobs ){
+			regions[ i ].file = packs[ p ].file;
+		}
+	}
+	// gains as for single files
+	const auto& normalization = settings.normalization;
+	const auto isLinked = normalization.isActive() && normalization.link != aud::Normalization::PerFile;
+	const auto linkedGains = isLinked ? getLinkedGains( jobs, settings ) : std::vector<float>();
+	if( sfzFile.getParentDirectory().createDirectory().failed() ){
+		return Result::fail( "unc::renderPack() Error creating " + sfzFile.getParentDirectory().getFullPathName() );
+	}
+	// temporary files of an interrupted render are never reused
+	const auto sfzFiles = getSfzFiles( sfzFile, ( int )regions.size() );
+	Array<File> targets( sfzFiles );
+	for( const auto& pack : packs ){
+		targets.add( pack.file );
+	}
+	aud::removeTemporaryFiles( targets );
+	// render ahead on all workers, append in order on the calling thread
+	const auto numAhead = ( getJobScheduler()->getNumWorkers() + 1 ) * PackJobsPerWorker;
+	String err;
+	for( const auto& pack : packs ){
+		if( err.isNotEmpty() ){
+			break;
+		}
+		const auto metadata = settings.output.format == aud::FileFormat::Wav ? createPackMetadata( regions, pack ) : StringPairArray();
+		aud::FileAppender appender( pack.file, pack.numChannels, pack.sampleRate, settings.output, metadata );
+		for( size_t first = 0; first < pack.jobs.size() && err.isEmpty(); first += ( size_t )numAhead ){
+			if( settings.cancel.isCancelled() ){
+				err << "unc::renderPack() Cancelled" << newLine;
+				break;
+			}
+			const auto num = jmin( ( size_t )numAhead, pack.jobs.size() - first );
+			std::vector<std::unique_ptr<AudioBuffer<float>>> rendered( num );
+			aud::parallelFor( ( int )num, [ & ]( int n ){
+				const auto i = pack.jobs[ first + ( size_t )n ];
+				UNC_TRACE_JOB( ( int )i );
+				auto& buf = rendered[ ( size_t )n ];
+				buf.reset( jobs[ i ].clip->writeAudio( jobs[ i ].zoneIndex, settings.isLoopBaked ) );
+				if( !buf ){
+					return;
+				}
+				UNC_TRACE_SCOPE( "gain" );
+				if( isLinked ){
+					buf->applyGain( linkedGains[ i ] );
+				}
+				else if( normalization.isActive() ){
+					buf->applyGain( aud::getNormalizationGain( aud::measureLoudness( *buf, jobs[ i ].clip->sampleRate ), normalization ) );
+				}
+			}, JobPriority::Batch );
+			for( size_t n = 0; n < num; ++n ){
+				const auto& region = regions[ pack.jobs[ first + n ] ];
+				if( !rendered[ n ] || rendered[ n ]->getNumSamples() != region.length || appender.getNumSamples() != region.offset ){
+					err << "unc::renderPack() Error rendering " << region.name << newLine;
+					break;
+				}
+				if( !appender.append( *rendered[ n ] ) ){
+					err << "unc::renderPack() Error writing " << pack.file.getFullPathName() << newLine;
+					break;
+				}
+			}
+		}
+		// packs of a failed render are dropped with their temporary file
+		if( err.isEmpty() && !appender.finish() ){
+			err << "unc::renderPack() Error writing " << pack.file.getFullPathName() << newLine;
+		}
+	}
+	// the mappings go last, so they only refer to complete packs
+	for( int s = 0; s < sfzFiles.size() && err.isEmpty(); ++s ){
+		const auto first = regions.begin() + s * MaxSfzRegions;
+		const std::vector<PackRegion> mapped( first, first + jmin( MaxSfzRegions, ( int )regions.size() - s * MaxSfzRegions ) );
+		TemporaryFile temp( sfzFiles[ s ] );
+		if( !temp.getFile().replaceWithText( createSfz( mapped, sfzFiles[ s ] ) ) || !aud::syncToDisk( temp.getFile() ) || !temp.overwriteTargetFileWithTemporary() ){
+			err << "unc::renderPack() Error writing " << sfzFiles[ s ].getFullPathName() << newLine;
+		}
+	}
+	Logger::writeToLog( "unc::renderPack() " + String( ( int )jobs.size() ) + " zones in " + String( ( int )packs.size() ) + " packs, " + String( sfzFiles.size() ) + " sfz" + newLine + getTraceSummary() );
+	return err.isEmpty() ? Result::ok() : Result::fail( err );
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include "AudioRender.h"
+
+namespace unc
+{
+	/// Where the audio of one zone lies in a pack.
+	struct PackRegion
+	{
+		String name;
+		String group;
+		File file;
+		int64 offset = 0;
+		int length = 0;
+		bool isLooping = false;
+		/// Loop start relative to offset, the loop ends with the region.
+		int loopStart = 0;
+		/// Key in its mapping, regions take consecutive keys from KeyMap::FirstNote in job order, a new mapping starts once all keys are used.
+		int key = -1;
+		int rootNote = -1;
+	};
+
+	/// \returns SFZ mapping of regions, one group per clip, samples relative to sfzFile.
+	/// Every region needs a key of its own.
+	String createSfz( const std::vector<PackRegion>& regions, const File& sfzFile );
+
+	/// \returns files of the mappings of numRegions regions, sfzFile followed by numbered siblings, each maps one region per key.
+	Array<File> getSfzFiles( const File& sfzFile, int numRegions );
+
+	/// Renders all jobs into one container file instead of one file per zone, and writes an SFZ mapping of its regions to sfzFile.
+	/// Zones are appended in job order, jobs of other sample rates or channel counts go to a pack of their own.
+	/// Every zone is mapped to a key of its own, played at the root note of its clip if known, see getSfzFiles() for more zones than keys.
+	/// Wav packs also index every region as labelled cue point, and looping regions as sample loops.
+	Result renderPack( const RenderJobs& jobs, const RenderSettings& settings, const File& sfzFile );
+}
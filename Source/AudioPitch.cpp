@@ -0,0 +1,195 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioPitch.h"
+
+using namespace aud;
+
+// PitchTrack - access
+String aud::PitchTrack::getRootNoteName() const
+{
+	if( !hasRootNote() ){
+		return String();
+	}
+	return MidiMessage::getMidiNoteName( getRootNote(), true, true, 3 );
+}
+
+// PitchTrack - persistence
+void aud::PitchTrack::toXml( XmlElement* xml )const
+{
+	xml->setAttribute( "rootNote", rootNote );
+	xml->setAttribute( "hopSize", hopSize );
+	MemoryBlock data( notes.data(), notes.size() * sizeof( float ) );
+	xml->setAttribute( "notes", data.toBase64Encoding() );
+}
+
+void aud::PitchTrack::fromXml( XmlElement* xml )
+{
+	rootNote = ( float )xml->getDoubleAttribute( "rootNote", 0. );
+	hopSize = xml->getIntAttribute( "hopSize", 0 );
+	MemoryBlock data;
+	data.fromBase64Encoding( xml->getStringAttribute( "notes" ) );
+	notes.resize( data.getSize() / sizeof( float ) );
+	data.copyTo( notes.data(), 0, notes.size() * sizeof( float ) );
+}
+
+// detectPitch
+/// Scratch memory for one analysis frame.
+struct PitchFrame
+{
+	PitchFrame( int order ) :
+		fft( order + 1 ),
+		length( 1 << order ),
+		samples( length ),
+		spectrum( fft.getSize() * 2 ),
+		difference( length / 2 )
+	{}
+
+	dsp::FFT fft; // zero padded to twice the frame, so the autocorrelation does not wrap
+	int length;
+	HeapBlock<float> samples;
+	HeapBlock<float> spectrum;
+	HeapBlock<float> difference;
+};
+
+/// \returns midi note of the frame, 0 if unvoiced.
+float detectFrameNote( PitchFrame& frame, double sampleRate )
+{
+	const float threshold = 0.15f;
+	const auto silence = Decibels::decibelsToGain( -50.f );
+	const auto len = frame.length;
+	const auto maxLag = len / 2;
+	const auto minLag = jmax( 2, roundToInt( sampleRate / 2000. ) );
+	const auto* x = frame.samples.get();
+	auto* d = frame.difference.get();
+	auto* r = frame.spectrum.get();
+
+	// silent frames are unvoiced
+	auto level = FloatVectorOperations::findMinAndMax( x, len );
+	if( jmax( -level.getStart(), level.getEnd() ) < silence ){
+		return 0.f;
+	}
+	// autocorrelation r(tau) from the power spectrum
+	FloatVectorOperations::clear( r, frame.fft.getSize() * 2 );
+	FloatVectorOperations::copy( r, x, len );
+	frame.fft.performRealOnlyForwardTransform( r );
+	for( int k = 0; k < frame.fft.getSize(); ++k ){
+		auto re = r[ 2 * k ];
+		auto im = r[ 2 * k + 1 ];
+		r[ 2 * k ] = re * re + im * im;
+		r[ 2 * k + 1 ] = 0.f;
+	}
+	frame.fft.performRealOnlyInverseTransform( r );
+
+	// difference d(tau) = m(tau) - 2r(tau), with m(tau) the energy of both shifted windows
+	double energy = 0.;
+	for( int j = 0; j < len; ++j ){
+		energy += x[ j ] * x[ j ];
+	}
+	const auto scale = r[ 0 ] > 0.f ? energy / r[ 0 ] : 0.; // independent of fft scaling
+	auto m = 2. * energy;
+	for( int tau = 0; tau < maxLag; ++tau ){
+		if( tau > 0 ){
+			m -= x[ len - tau ] * x[ len - tau ] + x[ tau - 1 ] * x[ tau - 1 ];
+		}
+		d[ tau ] = ( float )( m - 2. * scale * r[ tau ] );
+	}
+	// cumulative mean normalized difference
+	double sum = 0.;
+	d[ 0 ] = 1.f;
+	for( int tau = 1; tau < maxLag; ++tau ){
+		sum += d[ tau ];
+		d[ tau ] = sum > 0. ? ( float )( d[ tau ] * tau / sum ) : 1.f;
+	}
+	// first dip below threshold, followed down to its minimum
+	int best = -1;
+	for( int tau = minLag; tau < maxLag - 1; ++tau ){
+		if( d[ tau ] < threshold ){
+			while( tau + 2 < maxLag && d[ tau + 1 ] < d[ tau ] ){
+				++tau;
+			}
+			best = tau;
+			break;
+		}
+	}
+	if( best < 0 ){
+		return 0.f;
+	}
+	// parabolic interpolation of the lag
+	const auto a = d[ best - 1 ];
+	const auto b = d[ best ];
+	const auto c = d[ best + 1 ];
+	const auto denom = a + c - 2.f * b;
+	const auto lag = best + ( denom != 0.f ? 0.5f * ( a - c ) / denom : 0.f );
+	return ( float )( 69. + 12. * std::log2( sampleRate / lag / 440. ) );
+}
+
+PitchTrack aud::detectPitch( const AudioBuffer<float>& buffer, double sampleRate )
+{
+	PitchTrack ret;
+	const auto numChans = buffer.getNumChannels();
+	const auto numSamps = buffer.getNumSamples();
+	if( numChans == 0 || sampleRate <= 0. ){
+		return ret;
+	}
+	// frames hold two periods of ~40Hz
+	PitchFrame frame( sampleRate > 50000. ? 12 : 11 );
+	ret.hopSize = frame.length / 4;
+
+	// mono mix per frame
+	const auto gain = 1.f / numChans;
+	for( int pos = 0; pos + frame.length <= numSamps; pos += ret.hopSize ){
+		FloatVectorOperations::copyWithMultiply( frame.samples, buffer.getReadPointer( 0, pos ), gain, frame.length );
+		for( int ch = 1; ch < numChans; ++ch ){
+			FloatVectorOperations::addWithMultiply( frame.samples, buffer.getReadPointer( ch, pos ), gain, frame.length );
+		}
+		ret.notes.push_back( detectFrameNote( frame, sampleRate ) );
+	}
+	// root is the median of voiced frames
+	std::vector<float> voiced;
+	for( auto note : ret.notes ){
+		if( note > 0.f ){
+			voiced.push_back( note );
+		}
+	}
+	if( !voiced.empty() ){
+		auto median = voiced.begin() + voiced.size() / 2;
+		std::nth_element( voiced.begin(), median, voiced.end() );
+		ret.rootNote = *median;
+	}
+	return ret;
+}
+
+// findPitchTransition
+Range<int> aud::findPitchTransition( const PitchTrack& track )
+{
+	struct Segment
+	{
+		int begin;
+		int end;
+		float note;
+	};
+	// stable segments stay within half a semitone for some hops
+	const int minHops = 4;
+	const auto& notes = track.notes;
+	const auto numHops = ( int )notes.size();
+	std::vector<Segment> segments;
+	int begin = 0;
+	for( int i = 1; i <= numHops; ++i ){
+		if( i == numHops || notes[ i ] <= 0.f || notes[ begin ] <= 0.f || std::abs( notes[ i ] - notes[ begin ] ) > 0.5f ){
+			if( notes[ begin ] > 0.f && i - begin >= minHops ){
+				segments.push_back( { begin, i, notes[ begin ] } );
+			}
+			begin = i;
+		}
+	}
+	// last segment of the first note to first segment of the next, at frame centers
+	size_t first = 0;
+	for( size_t s = 1; s < segments.size(); ++s ){
+		if( std::abs( segments[ s ].note - segments[ first ].note ) < 1.f ){
+			first = s;
+			continue;
+		}
+		const auto center = track.hopSize * 2;
+		return { ( segments[ first ].end - 1 ) * track.hopSize + center, segments[ s ].begin * track.hopSize + center };
+	}
+	return Range<int>();
+}
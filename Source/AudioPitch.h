@@ -0,0 +1,34 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+namespace aud
+{
+	/// Pitch curve of a sample in midi notes, one value per hop, 0 where unvoiced.
+	struct PitchTrack
+	{
+		float rootNote = 0.f;
+		int hopSize = 0;
+		std::vector<float> notes;
+
+		// access
+		bool isAnalysed() const{ return hopSize > 0; }
+		bool hasRootNote() const{ return rootNote > 0.f; }
+		int getRootNote() const{ return roundToInt( rootNote ); }
+
+		/// \returns note name like "C#3", empty without root note.
+		String getRootNoteName() const;
+
+		// persistence
+		void toXml( XmlElement* xml )const;
+		void fromXml( XmlElement* xml );
+	};
+
+	/// Tracks pitch with YIN, the difference function is computed from an FFT autocorrelation.
+	PitchTrack detectPitch( const AudioBuffer<float>& buffer, double sampleRate );
+
+	/// Finds the glide between the first two stable notes of a legato sample.
+	/// \returns transition range in samples, empty if there is none.
+	Range<int> findPitchTransition( const PitchTrack& track );
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "AudioPitch.h"
+
+namespace aud
+{
+	class AudioPitchTest : public UnitTest
+	{
+	public:
+		AudioPitchTest() : UnitTest( "AudioPitchTest" ){}
+
+		void runTest() override
+		{
+			testDetectPitch();
+			testPitchTransition();
+			testPitchPersistence();
+		}
+
+		/// Writes a sine of the midi note into buffer, starting at phase 0.
+		void writeNote( AudioBuffer<float>& buffer, int start, int length, float note, double sampleRate )
+		{
+			auto freq = 440. * std::pow( 2., ( note - 69. ) / 12. );
+			for( int ch = 0; ch < buffer.getNumChannels(); ++ch ){
+				for( int i = 0; i < length; ++i ){
+					buffer.setSample( ch, start + i, 0.5f * ( float )std::sin( MathConstants<double>::twoPi * freq * i / sampleRate ) );
+				}
+			}
+		}
+
+		void testDetectPitch()
+		{
+			beginTest( "testDetectPitch" );
+
+			// A4
+			AudioBuffer<float> b( 2, 44100 );
+			writeNote( b, 0, 44100, 69.f, 44100. );
+			auto track = detectPitch( b, 44100. );
+			expect( track.isAnalysed() );
+			expect( track.hasRootNote() );
+			expectWithinAbsoluteError( track.rootNote, 69.f, 0.1f );
+			expectEquals( track.getRootNoteName(), String( "A3" ) );
+
+			// silence is unvoiced
+			b.clear();
+			track = detectPitch( b, 44100. );
+			expect( track.isAnalysed() );
+			expect( !track.hasRootNote() );
+		}
+
+		void testPitchTransition()
+		{
+			beginTest( "testPitchTransition" );
+
+			// A4 to C5 at half a second
+			AudioBuffer<float> b( 1, 44100 );
+			writeNote( b, 0, 22050, 69.f, 44100. );
+			writeNote( b, 22050, 22050, 72.f, 44100. );
+			auto track = detectPitch( b, 44100. );
+			auto transition = findPitchTransition( track );
+			expect( !transition.isEmpty() );
+			expect( transition.contains( 22050 ) );
+			expectLessThan( transition.getLength(), 4 * 2048 );
+
+			// no transition in a single note
+			writeNote( b, 0, 44100, 69.f, 44100. );
+			expect( findPitchTransition( detectPitch( b, 44100. ) ).isEmpty() );
+		}
+
+		void testPitchPersistence()
+		{
+			beginTest( "testPitchPersistence" );
+
+			PitchTrack track;
+			track.rootNote = 60.5f;
+			track.hopSize = 512;
+			track.notes = { 0.f, 60.f, 61.f };
+			XmlElement xml( "PitchTrack" );
+			track.toXml( &xml );
+
+			PitchTrack restored;
+			restored.fromXml( &xml );
+			expectEquals( restored.rootNote, track.rootNote );
+			expectEquals( restored.hopSize, track.hopSize );
+			expect( restored.notes == track.notes );
+		}
+	};
+	static AudioPitchTest audioPitchTest;
+}
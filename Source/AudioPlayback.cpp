@@ -3,6 +3,68 @@
 
 using namespace aud;
 
+// fades, crossfades and resampling round the same for any thread count or vector width
+UNC_DETERMINISTIC_FLOAT
+
+// getFadeCurve
+/// \returns gain at progress x from 0 to 1 through a fade.
+double getFadeGain( double x, FadeShape shape, bool isRising )
+{
+	if( shape == FadeShape::EqualPower ){
+		return isRising ? std::sin( x * MathConstants<double>::halfPi ) : std::cos( x * MathConstants<double>::halfPi );
+	}
+	return isRising ? x : 1. - x;
+}
+
+/// Cached curve and when it was last asked for.
+struct CachedFadeCurve
+{
+	std::shared_ptr<const FadeCurve> curve;
+	uint64 lastUsed = 0;
+};
+
+std::shared_ptr<const FadeCurve> aud::getFadeCurve( int length, double ratio, FadeShape shape, bool isRising )
+{
+	static CriticalSection lock;
+	static std::map<std::tuple<int, double, FadeShape, bool>, CachedFadeCurve> curves;
+	static uint64 numRequests = 0;
+	const ScopedLock sl( lock );
+	auto& cached = curves[ std::make_tuple( length, ratio, shape, isRising ) ];
+	cached.lastUsed = ++numRequests;
+	if( cached.curve != nullptr ){
+		return cached.curve;
+	}
+	// gains at the source position of each buffer sample, so long fades do not drift
+	auto curve = std::make_shared<FadeCurve>( FadeCurve{ length, ratio, shape, isRising, {} } );
+	const auto numGains = length > 0 && ratio > 0. ? ( int )std::ceil( length / ratio ) : 0;
+	curve->gains.resize( ( size_t )numGains );
+	for( int i = 0; i < numGains; ++i ){
+		curve->gains[ ( size_t )i ] = ( float )getFadeGain( i * ratio / length, shape, isRising );
+	}
+	cached.curve = curve;
+
+	// forget the least recently used, fades still playing it keep their own reference
+	if( curves.size() > MaxNumFadeCurves ){
+		auto oldest = std::min_element( curves.begin(), curves.end(), []( const auto& a, const auto& b ){
+			return a.second.lastUsed < b.second.lastUsed;
+		} );
+		curves.erase( oldest );
+	}
+	return curve;
+}
+
+/// Fetches the curve when settings changed, keeping pos at the same fade progress.
+void updateCurve( std::shared_ptr<const FadeCurve>& curve, int& pos, int length, double ratio, FadeShape shape, bool isRising )
+{
+	if( curve != nullptr && curve->length == length && curve->ratio == ratio && curve->shape == shape ){
+		return;
+	}
+	if( curve != nullptr && pos > 0 ){
+		pos = roundToInt( pos * curve->ratio / ratio );
+	}
+	curve = getFadeCurve( length, ratio, shape, isRising );
+}
+
 // FadeIn
 FadeIn::FadeIn( int fadeLength_ ) :
 	fadeLength( fadeLength_ )
@@ -40,24 +102,13 @@ int FadeIn::process( AudioBuffer<float>& audioBuffer, int fadePos, double playRa
 	if( fadeLength <= 0 ){
 		return srcEnd;
 	}
-	// apply gain ramp
-	double inc = playRatio / fadeLength;
-	double a = alpha;
-	auto len = destLen;
-
-	// channels
+	// apply gain ramp, fully faded in past its end
+	updateCurve( curve, curvePos, fadeLength, playRatio, shape, true );
+	const auto len = jlimit( 0, destLen, ( int )curve->gains.size() - curvePos );
 	for( int ch = 0; ch < audioBuffer.getNumChannels(); ++ch ){
-		auto* samp = audioBuffer.getWritePointer( ch, destStart );
-		a = alpha;
-		len = destLen;
-
-		// samples
-		while( --len >= 0 ){
-			*samp++ *= a;
-			a += inc;
-		}
+		FloatVectorOperations::multiply( audioBuffer.getWritePointer( ch, destStart ), curve->gains.data() + curvePos, len );
 	}
-	alpha = a;
+	curvePos += destLen;
 	return srcEnd;
 }
 
@@ -98,31 +149,141 @@ int FadeOut::process( AudioBuffer<float>& audioBuffer, int fadePos, double playR
 	if( fadeLength == 0 ){
 		return srcEnd;
 	}
-	// apply gain ramp
-	double i = playRatio / fadeLength;
-	double a = alpha;
-	auto l = destLen;
+	// apply gain ramp, silent past its end
+	updateCurve( curve, curvePos, fadeLength, playRatio, shape, false );
+	const auto len = jlimit( 0, destLen, ( int )curve->gains.size() - curvePos );
 	for( int ch = 0; ch < audioBuffer.getNumChannels(); ++ch ){
-		auto* s = audioBuffer.getWritePointer( ch, destStart );
-		a = alpha;
-		l = destLen;
-		while( --l >= 0 ){
-			*s++ *= a;
-			a -= i;
-		}
+		FloatVectorOperations::multiply( audioBuffer.getWritePointer( ch, destStart ), curve->gains.data() + curvePos, len );
 	}
-	alpha = a;
+	audioBuffer.clear( destStart + len, destLen - len );
+	curvePos += destLen;
 	return srcEnd;
 }
 
+// MultiChannelInterpolator
+/// Same term order as juce's CatmullRomAlgorithm, y0 is the oldest input.
+inline float catmullRomAtOffset( float y0, float y1, float y2, float y3, float offset )
+{
+	auto halfY0 = 0.5f * y0;
+	auto halfY3 = 0.5f * y3;
+	return y1 + offset * ( ( 0.5f * y2 - halfY0 )
+		+ ( offset * ( ( ( y0 + 2.f * y2 ) - ( halfY3 + 2.5f * y1 ) )
+		+ ( offset * ( ( halfY3 + 1.5f * y1 ) - ( halfY0 + 1.5f * y2 ) ) ) ) ) );
+}
+
+template <int NumChans>
+int aud::MultiChannelInterpolator::interpolate( MultiChannelInterpolator& state, double ratio, const float* ratios, const float* const* in, float* const* out, int numChans, int numOut, int available )
+{
+	// constant for fixed kernels, so the channel loops unroll
+	const int n = NumChans > 0 ? NumChans : numChans;
+	auto* history = state.history;
+	int numPushed = 0;
+	auto push = [ & ](){
+		memmove( history + n, history, sizeof( float ) * ( size_t )( 4 * n ) );
+		for( int ch = 0; ch < n; ++ch ){
+			history[ ch ] = numPushed < available ? in[ ch ][ numPushed ] : 0.f;
+		}
+		++numPushed;
+	};
+	auto write = [ & ]( int i, float offset ){
+		for( int ch = 0; ch < n; ++ch ){
+			out[ ch ][ i ] = catmullRomAtOffset( history[ 3 * n + ch ], history[ 2 * n + ch ], history[ n + ch ], history[ ch ], offset );
+		}
+	};
+
+	// unity copies, keeping the last frames for a ratio change
+	if( ratios == nullptr && ratio == 1. ){
+		const auto numCopied = jlimit( 0, numOut, available );
+		for( int ch = 0; ch < n; ++ch ){
+			FloatVectorOperations::copy( out[ ch ], in[ ch ], numCopied );
+			FloatVectorOperations::clear( out[ ch ] + numCopied, numOut - numCopied );
+		}
+		numPushed = jmax( 0, numOut - 5 );
+		while( numPushed < numOut ){
+			push();
+		}
+		return numOut;
+	}
+	auto pos = state.subSamplePos;
+	if( ratios != nullptr ){
+		// any ratio per sample, juce's form for ratios below 1
+		for( int i = 0; i < numOut; ++i ){
+			while( pos >= 1. ){
+				push();
+				pos -= 1.;
+			}
+			write( i, ( float )pos );
+			pos += ratios[ i ];
+		}
+	}
+	else if( ratio < 1. ){
+		for( int i = 0; i < numOut; ++i ){
+			if( pos >= 1. ){
+				push();
+				pos -= 1.;
+			}
+			write( i, ( float )pos );
+			pos += ratio;
+		}
+	}
+	else{
+		for( int i = 0; i < numOut; ++i ){
+			while( pos < ratio ){
+				push();
+				pos += 1.;
+			}
+			pos -= ratio;
+			write( i, jmax( 0.f, 1.f - ( float )pos ) );
+		}
+	}
+	state.subSamplePos = pos;
+	return jmin( numPushed, jmax( 0, available ) );
+}
+
+// MultiChannelInterpolator - process
+int aud::MultiChannelInterpolator::process( double ratio, const float* const* in, float* const* out, int numChans, int numOut, int available )
+{
+	jassert( isPositiveAndNotGreaterThan( numChans, ( int )MaxNumAudioChannels ) );
+	auto* k = numChans == numChannels ? kernel : &interpolate<0>;
+	return k( *this, ratio, nullptr, in, out, numChans, numOut, available );
+}
+
+int aud::MultiChannelInterpolator::process( const float* ratios, const float* const* in, float* const* out, int numChans, int numOut, int available )
+{
+	jassert( isPositiveAndNotGreaterThan( numChans, ( int )MaxNumAudioChannels ) );
+	auto* k = numChans == numChannels ? kernel : &interpolate<0>;
+	return k( *this, 1., ratios, in, out, numChans, numOut, available );
+}
+
+// MultiChannelInterpolator - modify
+void aud::MultiChannelInterpolator::reset()
+{
+	subSamplePos = 1.;
+	memset( history, 0, sizeof( history ) );
+}
+
+void aud::MultiChannelInterpolator::setNumChannels( int numChans )
+{
+	numChannels = numChans;
+	switch( numChans ){
+		case 1: kernel = &interpolate<1>; break;
+		case 2: kernel = &interpolate<2>; break;
+		case 4: kernel = &interpolate<4>; break;
+		case 8: kernel = &interpolate<8>; break;
+		default: kernel = &interpolate<0>; break;
+	}
+}
+
 // Resampler
 Resampler::Resampler( const AudioBuffer<float>& sample_ ) :
 	rangeLength( sample_.getNumSamples() ),
-	sample( sample_ )
-{}
+	sample( &sample_ )
+{
+	interpolator.setNumChannels( getNumPlayedChannels( *sample ) );
+}
 
 // Resampler - process
-int Resampler::process( AudioBuffer<float>& audioBuffer )
+int Resampler::process( AudioBuffer<float>& audioBuffer, const float* ratios )
 {
 	audioBuffer.clear();
 
@@ -147,22 +308,41 @@ int Resampler::process( AudioBuffer<float>& audioBuffer )
 	if( playPos >= rangeLength ){
 		return playPosition;
 	}
-	// scale len with timestretch, offset pos to actual read range
-	const int srcLen = sample.getNumSamples() - playPos;
+	// offset pos to actual read range, which may be read up to the sample end
 	const int srcPos = playPos + rangeStart;
+	const int srcLen = sample->getNumSamples() - srcPos;
 
-	// resample channels with some mono-stereo channel wrapping
-	int numDestChans = jmin( ( int )resampler.size(), audioBuffer.getNumChannels() );
+	// resample all source channels at once, further destination channels wrap around them
+	const int numDestChans = jmin( ( int )MaxNumAudioChannels, audioBuffer.getNumChannels() );
+	const int numChans = jmin( getNumPlayedChannels( *sample ), numDestChans );
+	const auto phase = interpolator.getPhase();
 	int numRead = 0;
-	for( int destCh = 0; destCh < numDestChans; ++destCh ){
-		int sourceCh = destCh % sample.getNumChannels();
-		auto* read = sample.getReadPointer( sourceCh, srcPos );
-		auto* write = audioBuffer.getWritePointer( destCh, destPos );
-		numRead = resampler[ destCh ].process( sampleRatio, read, write, destLen, srcLen, 0 );
+	{
+		UNC_TRACE_SCOPE( "resample" );
+		const float* read[ MaxNumAudioChannels ];
+		float* write[ MaxNumAudioChannels ];
+		for( int ch = 0; ch < numChans; ++ch ){
+			read[ ch ] = sample->getReadPointer( ch, srcPos );
+			write[ ch ] = audioBuffer.getWritePointer( ch, destPos );
+		}
+		if( ratios != nullptr ){
+			numRead = interpolator.process( ratios + destPos, read, write, numChans, destLen, srcLen );
+		}
+		else{
+			numRead = interpolator.process( sampleRatio, read, write, numChans, destLen, srcLen );
+		}
+		for( int destCh = numChans; destCh < numDestChans; ++destCh ){
+			audioBuffer.copyFrom( destCh, destPos, audioBuffer, destCh % numChans, destPos, destLen );
+		}
 	}
 	// when timestretching, this might differ from playEnd
 	playPosition = playPos + numRead;
-
+	UNC_TRACE_SCOPE( "fade" );
+	if( ratios != nullptr ){
+		// the first output sits phase past the last input read
+		applyFades( audioBuffer, destPos, destLen, playPos + phase - 1., ratios );
+		return playPosition;
+	}
 	// fade in begin is at range 0, destPos is 0 except at fade bounds
 	fadeIn.process( audioBuffer, playPos - destPos, sampleRatio );
 
@@ -172,13 +352,46 @@ int Resampler::process( AudioBuffer<float>& audioBuffer )
 	return playPosition;
 }
 
+void Resampler::applyFades( AudioBuffer<float>& audioBuffer, int destPos, int destLen, double pos, const float* ratios )
+{
+	const auto fadeInLength = fadeIn.getLength();
+	const auto fadeOutLength = fadeOut.getLength();
+	const auto fadeOutBegin = rangeLength - fadeOutLength;
+	const auto numChans = audioBuffer.getNumChannels();
+	auto* const* channels = audioBuffer.getArrayOfWritePointers();
+	for( int i = destPos; i < destPos + destLen; ++i ){
+		auto gain = 1.;
+		if( pos < fadeInLength ){
+			gain = getFadeGain( jmax( 0., pos / fadeInLength ), fadeShape, true );
+		}
+		// nothing plays past the range
+		if( pos >= fadeOutBegin ){
+			gain *= fadeOutLength > 0 ? getFadeGain( jlimit( 0., 1., ( pos - fadeOutBegin ) / fadeOutLength ), fadeShape, false ) : 0.;
+		}
+		if( gain != 1. ){
+			for( int ch = 0; ch < numChans; ++ch ){
+				channels[ ch ][ i ] *= ( float )gain;
+			}
+		}
+		pos += ratios[ i ];
+	}
+}
+
 // Resampler - modify
+void Resampler::setSample( const AudioBuffer<float>& newSample )
+{
+	sample = &newSample;
+	rangeStart = 0;
+	rangeLength = newSample.getNumSamples();
+	interpolator.setNumChannels( getNumPlayedChannels( *sample ) );
+}
+
 void Resampler::setRange( int start, int length )
 {
 	if( length < 0 ){
         length = 0;
 	}
-	auto numSamps = sample.getNumSamples();
+	auto numSamps = sample->getNumSamples();
 	auto end = start + length;
 	start = jlimit( 0, numSamps, start );
 	end = jlimit( 0, numSamps, end );
@@ -189,9 +402,7 @@ void Resampler::setRange( int start, int length )
 void Resampler::reset( int playPos )
 {
 	playPosition = playPos;
-	for( auto& r : resampler ){
-		r.reset();
-	}
+	interpolator.reset();
 	fadeIn.reset();
 	fadeOut.reset();
 }
@@ -218,3 +429,93 @@ void Resampler::setFadeOut( int fadeLength )
 	}
 	fadeOut.setLength( fadeLength );
 }
+
+void Resampler::setFadeShape( FadeShape shape )
+{
+	fadeIn.setShape( shape );
+	fadeOut.setShape( shape );
+	fadeShape = shape;
+}
+
+// renderLoop
+void aud::renderLoop( const AudioBuffer<float>& source, int start, int length, int xFade, AudioBuffer<float>& dest )
+{
+	const auto loopLength = dest.getNumSamples();
+	jassert( loopLength == length - xFade && start >= 0 );
+
+	// source past its end is silent
+	const auto seamStart = jmax( 0, loopLength - xFade );
+	const auto seamLength = loopLength - seamStart;
+	const auto numBody = jlimit( 0, loopLength, source.getNumSamples() - start - xFade );
+	const auto numHead = jlimit( 0, xFade, source.getNumSamples() - start );
+	const auto numFused = jlimit( 0, seamLength, jmin( numBody - seamStart, numHead ) );
+	const auto fadeOut = getFadeCurve( xFade, 1., FadeShape::Linear, false );
+	const auto fadeIn = getFadeCurve( xFade, 1., FadeShape::Linear, true );
+	const auto* out = fadeOut->gains.data();
+	const auto* in = fadeIn->gains.data();
+	const auto numChans = jmin( getNumPlayedChannels( source ), dest.getNumChannels() );
+	for( int ch = 0; ch < numChans; ++ch ){
+		const auto* head = source.getReadPointer( ch ) + start;
+		const auto* body = head + xFade;
+		auto* write = dest.getWritePointer( ch );
+
+		// body up to the seam is copied
+		const auto numCopied = jmin( seamStart, numBody );
+		FloatVectorOperations::copy( write, body, numCopied );
+		FloatVectorOperations::clear( write + numCopied, seamStart - numCopied );
+
+		// seam fades body out and head in with each sample touched once
+		auto* seam = write + seamStart;
+		const auto* seamBody = body + seamStart;
+		for( int i = 0; i < numFused; ++i ){
+			seam[ i ] = seamBody[ i ] * out[ i ] + head[ i ] * in[ i ];
+		}
+		for( int i = numFused; i < seamLength; ++i ){
+			const auto b = seamStart + i < numBody ? seamBody[ i ] : 0.f;
+			const auto h = i < numHead ? head[ i ] : 0.f;
+			seam[ i ] = b * out[ i ] + h * in[ i ];
+		}
+	}
+}
+
+// RatioEnvelope - process
+void aud::RatioEnvelope::render( float* dest, int startSample, int numSamples ) const
+{
+	if( points.empty() ){
+		FloatVectorOperations::fill( dest, 1.f, numSamples );
+		return;
+	}
+	const auto end = startSample + numSamples;
+	int pos = startSample;
+	auto hold = [ & ]( int until, float ratio ){
+		const auto len = jlimit( 0, end - pos, until - pos );
+		FloatVectorOperations::fill( dest + pos - startSample, ratio, len );
+		pos += len;
+	};
+	hold( points.front().position, points.front().ratio );
+
+	// ramps are computed per sample independently, so they vectorize
+	for( size_t k = 1; k < points.size() && pos < end; ++k ){
+		const auto& a = points[ k - 1 ];
+		const auto& b = points[ k ];
+		const auto len = jlimit( 0, end - pos, b.position - pos );
+		if( len == 0 ){
+			continue;
+		}
+		const auto step = ( b.ratio - a.ratio ) / ( b.position - a.position );
+		const auto first = a.ratio + step * ( pos - a.position );
+		auto* d = dest + pos - startSample;
+		for( int i = 0; i < len; ++i ){
+			d[ i ] = first + step * i;
+		}
+		pos += len;
+	}
+	hold( end, points.back().ratio );
+}
+
+// RatioEnvelope - modify
+void aud::RatioEnvelope::addPoint( int position, float ratio )
+{
+	jassert( points.empty() || position >= points.back().position );
+	points.push_back( { position, ratio } );
+}
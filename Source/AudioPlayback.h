@@ -3,11 +3,36 @@
 
 #include "MainHeaders.h"
 
+#include "Trace.h"
+
 namespace aud
 {
-	const static size_t MaxNumAudioChannels( 2 );
+	/// Most channels played from a source, enough for third order ambisonics.
+	const static size_t MaxNumAudioChannels( 16 );
 	const static double MaxPlaybackRatio( 4 );
 
+	enum class FadeShape
+	{
+		Linear, EqualPower
+	};
+
+	/// Gains of a fade over length source samples played at ratio, one per buffer sample.
+	struct FadeCurve
+	{
+		int length;
+		double ratio;
+		FadeShape shape;
+		bool isRising;
+		std::vector<float> gains;
+	};
+
+	/// \returns the curve for these settings, computed once and shared by all fades using them while it is cached.
+	/// Thread safe, but locks, so fetch curves before playback where possible.
+	std::shared_ptr<const FadeCurve> getFadeCurve( int length, double ratio, FadeShape shape, bool isRising );
+
+	/// Curves kept by getFadeCurve(), the least recently used are dropped beyond.
+	const static size_t MaxNumFadeCurves( 64 );
+
 	/// A fade in with a dynamically changeable length.
 	class FadeIn
 	{
@@ -20,15 +45,18 @@ namespace aud
 		int process( AudioBuffer<float>& audioBuffer, int fadePos, double playRatio );
 
 		// modify
-		void reset(){ alpha = 0.; }
+		void reset(){ curvePos = 0; }
 		void setLength( int newLength ){ fadeLength = newLength; }
+		void setShape( FadeShape newShape ){ shape = newShape; }
 
 		// access
 		int getLength() const{ return fadeLength; }
 
 	private:
 		int fadeLength;
-		double alpha = 0.f;
+		FadeShape shape = FadeShape::Linear;
+		std::shared_ptr<const FadeCurve> curve;
+		int curvePos = 0;
 	};
 
 	/// A fade out with a dynamically changeable length.
@@ -43,15 +71,66 @@ namespace aud
 		int process( AudioBuffer<float>& audioBuffer, int fadePos, double playRatio );
 
 		// modify
-		void reset(){ alpha = 1.; }
+		void reset(){ curvePos = 0; }
 		void setLength( int newLength ){ fadeLength = newLength; }
+		void setShape( FadeShape newShape ){ shape = newShape; }
 
 		// access
 		int getLength() const{ return fadeLength; }
 
 	private:
 		int fadeLength;
-		double alpha = 1.f;
+		FadeShape shape = FadeShape::Linear;
+		std::shared_ptr<const FadeCurve> curve;
+		int curvePos = 0;
+	};
+
+	/// \returns number of source channels played, no more than MaxNumAudioChannels.
+	inline int getNumPlayedChannels( const AudioBuffer<float>& source )
+	{
+		return jmin( source.getNumChannels(), ( int )MaxNumAudioChannels );
+	}
+
+	/// Catmull-Rom interpolation of all channels in one pass per output frame, sample exact to juce::CatmullRomInterpolator.
+	/// Histories are kept per frame across channels, common layouts have their own fixed size kernels.
+	class MultiChannelInterpolator
+	{
+	public:
+		MultiChannelInterpolator(){ setNumChannels( 0 ); reset(); }
+
+		// process
+		/// Interpolates numChans channels of in to numOut samples of out, input after available samples is silent.
+		/// \returns number of input samples used.
+		int process( double ratio, const float* const* in, float* const* out, int numChans, int numOut, int available );
+
+		/// Like above, with one ratio per output sample. Matches the constant ratio below 1, above it the phase differs.
+		int process( const float* ratios, const float* const* in, float* const* out, int numChans, int numOut, int available );
+
+		// modify
+		void reset();
+
+		/// Selects the kernel used while process() is called with numChans channels.
+		void setNumChannels( int numChans );
+
+		// access
+		/// \returns offset of the next output after the newest input used, 1 or more takes a new input first.
+		double getPhase() const{ return subSamplePos; }
+
+	private:
+		using Kernel = int( * )( MultiChannelInterpolator&, double, const float*, const float* const*, float* const*, int, int, int );
+
+		/// NumChans 0 takes the count at runtime, ratios overrides ratio if given.
+		template <int NumChans>
+		static int interpolate( MultiChannelInterpolator& state, double ratio, const float* ratios, const float* const* in, float* const* out, int numChans, int numOut, int available );
+
+		Kernel kernel;
+		int numChannels = 0;
+		double subSamplePos = 1.;
+
+		/// Last input frames, newest first, each numChans wide.
+		float history[ 5 * MaxNumAudioChannels ];
+
+		JUCE_DECLARE_NON_COPYABLE( MultiChannelInterpolator );
 	};
 
 	/// Play a given range inside an audio sample with variable speed. All access should be from within or before entering audio thread.
@@ -61,10 +140,14 @@ namespace aud
 		Resampler( const AudioBuffer<float>& sample_ );
 
 		// process
+		/// \param ratios if given, overrides the ratio for each buffer sample, fades then follow the source positions read.
 		/// \returns next playPos relative to range.
-		int process( AudioBuffer<float>& audioBuffer );
+		int process( AudioBuffer<float>& audioBuffer, const float* ratios = nullptr );
 
 		// modify
+		/// Plays newSample, which must outlive playback, range is reset to all of it.
+		void setSample( const AudioBuffer<float>& newSample );
+
 		/// Positions are relative to audio sample, must be within bounds.
 		void setRange( int start, int length );
 
@@ -80,6 +163,9 @@ namespace aud
 		void setFadeOut( int fadeLength );
 		/// @}
 
+		/// Shape of both fades, linear by default.
+		void setFadeShape( FadeShape shape );
+
 		// access
 		/// \returns playPos relative to range.
 		int getPlayPos() const{ return playPosition; }
@@ -101,15 +187,51 @@ namespace aud
 		int rangeStart = 0;
 		int rangeLength;
 		double sampleRatio = 1.f;
-		const AudioBuffer<float>& sample;
+		const AudioBuffer<float>* sample;
 
 		/// Fades are relative to range.
 		FadeIn fadeIn{ 0 };
 		FadeOut fadeOut{ 0 };
-        std::array<CatmullRomInterpolator, MaxNumAudioChannels> resampler{};
+		FadeShape fadeShape = FadeShape::Linear;
+		MultiChannelInterpolator interpolator;
+
+		/// Applies both fades at the source position of each buffer sample, starting at pos.
+		void applyFades( AudioBuffer<float>& audioBuffer, int destPos, int destLen, double pos, const float* ratios );
 
 		JUCE_DECLARE_NON_COPYABLE( Resampler );
 	};
+
+	/// Renders the range of length from start as a seamless loop at unity ratio, in one pass without temporary buffers.
+	/// The loop body starts xFade into the range, its last xFade samples crossfade linearly into the range start.
+	/// \param dest must hold length - xFade samples.
+	void renderLoop( const AudioBuffer<float>& source, int start, int length, int xFade, AudioBuffer<float>& dest );
+
+	/// Playback ratio over buffer samples, linear between points and held before the first and after the last.
+	class RatioEnvelope
+	{
+	public:
+		// process
+		/// Writes the ratios of numSamples buffer samples from startSample to dest.
+		void render( float* dest, int startSample, int numSamples ) const;
+
+		// modify
+		/// Points must be added in order of position.
+		void addPoint( int position, float ratio );
+		void clear(){ points.clear(); }
+
+		// access
+		bool isEmpty() const{ return points.empty(); }
+
+	private:
+		struct Point
+		{
+			int position;
+			float ratio;
+		};
+		std::vector<Point> points;
+
+		JUCE_LEAK_DETECTOR( RatioEnvelope );
+	};
 	    
     /// \param normalized between 0. and 1., with 0.5 being neutral.
     /// \returns speed of playback between 0.25 and 4.
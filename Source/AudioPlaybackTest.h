@@ -22,6 +22,10 @@ namespace aud
 			testResamplerFadeIn();
 			testResamplerFadeOut();
 			testResamplerPlaySpeedBounds();
+			testInterpolator();
+			testRatioEnvelope();
+			testFadeCurves();
+			testRenderLoop();
 		}
 
 		void testResampler()
@@ -516,6 +520,154 @@ namespace aud
 				}
 			}
 		}
+
+		void testInterpolator()
+		{
+			beginTest( "testInterpolator" );
+
+			// random quad input, long enough for every block
+			Random random( 1 );
+			AudioBuffer<float> b( 4, 512 );
+			for( int ch = 0; ch < b.getNumChannels(); ++ch ){
+				for( int i = 0; i < b.getNumSamples(); ++i ){
+					b.setSample( ch, i, random.nextFloat() * 2.f - 1.f );
+				}
+			}
+			AudioBuffer<float> expected( 4, 16 );
+			AudioBuffer<float> o( 4, 16 );
+
+			// must match juce per channel, with ratio changes between blocks, three channels take the runtime kernel
+			for( int numChans = 1; numChans <= 4; ++numChans ){
+				std::array<CatmullRomInterpolator, 4> reference;
+				MultiChannelInterpolator m;
+				m.setNumChannels( numChans );
+				int pos = 0;
+				for( double ratio : { 0.37, 1., 1.5, 1., 0.8, 3.2, 2. } ){
+					int numUsed = 0;
+					for( int ch = 0; ch < numChans; ++ch ){
+						numUsed = reference[ ch ].process( ratio, b.getReadPointer( ch, pos ), expected.getWritePointer( ch ), o.getNumSamples(), b.getNumSamples() - pos, 0 );
+					}
+					const float* read[] = { b.getReadPointer( 0, pos ), b.getReadPointer( 1, pos ), b.getReadPointer( 2, pos ), b.getReadPointer( 3, pos ) };
+					expectEquals( m.process( ratio, read, o.getArrayOfWritePointers(), numChans, o.getNumSamples(), b.getNumSamples() - pos ), numUsed );
+					for( int ch = 0; ch < numChans; ++ch ){
+						for( int i = 0; i < o.getNumSamples(); ++i ){
+							expectEquals( o.getSample( ch, i ), expected.getSample( ch, i ) );
+						}
+					}
+					pos += numUsed;
+				}
+			}
+		}
+
+		void testRatioEnvelope()
+		{
+			beginTest( "testRatioEnvelope" );
+
+			// held outside points, linear between
+			RatioEnvelope e;
+			e.addPoint( 2, 1.f );
+			e.addPoint( 6, 2.f );
+			float ratios[ 8 ];
+			e.render( ratios, 0, 8 );
+			const float expected[] = { 1.f, 1.f, 1.f, 1.25f, 1.5f, 1.75f, 2.f, 2.f };
+			for( int i = 0; i < 8; ++i ){
+				expectEquals( ratios[ i ], expected[ i ] );
+			}
+			// constant ratios below 1 play like the fixed ratio
+			AudioBuffer<float> b( 1, 32 );
+			Random random( 2 );
+			for( int i = 0; i < b.getNumSamples(); ++i ){
+				b.setSample( 0, i, random.nextFloat() );
+			}
+			Resampler fixed( b );
+			fixed.setRatio( 0.5 );
+			Resampler varying( b );
+			AudioBuffer<float> o( 1, 16 );
+			AudioBuffer<float> p( 1, 16 );
+			HeapBlock<float> half( 16 );
+			FloatVectorOperations::fill( half, 0.5f, 16 );
+			for( int block = 0; block < 3; ++block ){
+				expectEquals( varying.process( p, half ), fixed.process( o ) );
+				for( int i = 0; i < o.getNumSamples(); ++i ){
+					expectEquals( p.getSample( 0, i ), o.getSample( 0, i ) );
+				}
+			}
+			// fades follow the source position at twice the speed
+			for( int i = 0; i < b.getNumSamples(); ++i ){
+				b.setSample( 0, i, 1.f );
+			}
+			Resampler r( b );
+			r.setFadeIn( 8 );
+			r.setFadeOut( 8 );
+			AudioBuffer<float> f( 1, 20 );
+			HeapBlock<float> twice( 20 );
+			FloatVectorOperations::fill( twice, 2.f, 20 );
+			expectEquals( r.process( f, twice ), 32 );
+			expectEquals( f.getSample( 0, 1 ), 0.25f );
+			expectEquals( f.getSample( 0, 2 ), 0.5f );
+			expectEquals( f.getSample( 0, 3 ), 0.75f );
+			expectEquals( f.getSample( 0, 8 ), 1.f );
+			expectEquals( f.getSample( 0, 13 ), 0.75f );
+			expectEquals( f.getSample( 0, 14 ), 0.5f );
+			expectEquals( f.getSample( 0, 15 ), 0.25f );
+			expectEquals( f.getSample( 0, 16 ), 0.f );
+		}
+
+		void testFadeCurves()
+		{
+			beginTest( "testFadeCurves" );
+
+			// same settings share one curve
+			auto curve = getFadeCurve( 8, 2., FadeShape::Linear, true );
+			expect( curve == getFadeCurve( 8, 2., FadeShape::Linear, true ) );
+			expect( curve != getFadeCurve( 8, 2., FadeShape::Linear, false ) );
+
+			// one gain per buffer sample, at its source position
+			expectEquals( ( int )curve->gains.size(), 4 );
+			expectEquals( curve->gains[ 1 ], 0.25f );
+			auto power = getFadeCurve( 4, 1., FadeShape::EqualPower, false );
+			expectEquals( power->gains[ 0 ], 1.f );
+			expectWithinAbsoluteError( power->gains[ 2 ], std::sqrt( 0.5f ), 0.00001f );
+
+			// faster playback passes the fade sooner, without overshooting
+			AudioBuffer<float> b( 1, 8 );
+			FloatVectorOperations::fill( b.getWritePointer( 0 ), 1.f, b.getNumSamples() );
+			FadeIn f( 8 );
+			f.process( b, 0, 2. );
+			expectEquals( b.getSample( 0, 3 ), 0.75f );
+			expectEquals( b.getSample( 0, 4 ), 1.f );
+			expectEquals( b.getSample( 0, 7 ), 1.f );
+
+			// cache is bounded, the least recently used curve is computed anew
+			auto recent = getFadeCurve( 7, 1., FadeShape::Linear, true );
+			auto old = getFadeCurve( 9, 1., FadeShape::Linear, true );
+			for( int length = 10; length < 10 + ( int )MaxNumFadeCurves; ++length ){
+				getFadeCurve( 7, 1., FadeShape::Linear, true );
+				getFadeCurve( length, 1., FadeShape::Linear, true );
+			}
+			expect( recent == getFadeCurve( 7, 1., FadeShape::Linear, true ) );
+			expect( old != getFadeCurve( 9, 1., FadeShape::Linear, true ) );
+		}
+
+		void testRenderLoop()
+		{
+			beginTest( "testRenderLoop" );
+
+			// read from this buffer
+			AudioBuffer<float> b( 1, 6 );
+			for( int i = 0; i < b.getNumSamples(); ++i ){
+				b.setSample( 0, i, 0.1f * ( i + 1 ) );
+			}
+			// body from 3, seam of 2 into 1
+			AudioBuffer<float> o( 1, 4 );
+			renderLoop( b, 1, 6, 2, o );
+			expectWithinAbsoluteError( o.getSample( 0, 0 ), 0.4f, 0.00001f );
+			expectWithinAbsoluteError( o.getSample( 0, 1 ), 0.5f, 0.00001f );
+			expectWithinAbsoluteError( o.getSample( 0, 2 ), 0.6f, 0.00001f );
+
+			// body runs past the sample end, only the head is heard there
+			expectWithinAbsoluteError( o.getSample( 0, 3 ), 0.5f * 0.3f, 0.00001f );
+		}
 	};
 	static AudioPlaybackTest audioPlaybackTest;
 }
@@ -0,0 +1,129 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioPreview.h"
+
+using namespace aud;
+
+// PreviewPlayer
+aud::PreviewPlayer::PreviewPlayer()
+{
+	startTimerHz( 10 );
+}
+
+aud::PreviewPlayer::~PreviewPlayer()
+{
+	// the device callback must be removed before
+	stopTimer();
+	timerCallback();
+	delete pending.exchange( nullptr );
+	delete current;
+	delete fading;
+}
+
+// PreviewPlayer - modify
+void aud::PreviewPlayer::play( AudioBuffer<float>* buffer, bool shouldLoop )
+{
+	auto* preview = new Preview();
+	preview->buffer.reset( buffer );
+	preview->isLooping = shouldLoop;
+
+	// a preview not yet picked up by the audio thread is still ours
+	delete pending.exchange( preview );
+}
+
+// PreviewPlayer - AudioIODeviceCallback
+void aud::PreviewPlayer::audioDeviceIOCallback( const float**, int, float** outputChannelData, int numOutputChannels, int numSamples )
+{
+	for( int ch = 0; ch < numOutputChannels; ++ch ){
+		if( outputChannelData[ ch ] != nullptr ){
+			FloatVectorOperations::clear( outputChannelData[ ch ], numSamples );
+		}
+	}
+	// switch, the previous preview fades out while the new one fades in
+	if( auto* next = pending.exchange( nullptr ) ){
+		if( fading != nullptr ){
+			retire( fading );
+		}
+		fading = current;
+		current = next;
+	}
+	const auto step = 1.f / DeclickLength;
+	if( current != nullptr ){
+		addPreview( *current, outputChannelData, numOutputChannels, numSamples, step );
+	}
+	if( fading != nullptr ){
+		addPreview( *fading, outputChannelData, numOutputChannels, numSamples, -step );
+		if( fading->gain <= 0.f ){
+			retire( fading );
+			fading = nullptr;
+		}
+	}
+}
+
+void aud::PreviewPlayer::audioDeviceAboutToStart( AudioIODevice* )
+{}
+
+void aud::PreviewPlayer::audioDeviceStopped()
+{}
+
+// PreviewPlayer - process
+void aud::PreviewPlayer::addPreview( Preview& preview, float* const* output, int numChannels, int numSamples, float gainStep )
+{
+	const auto* source = preview.buffer.get();
+	const auto gainStart = preview.gain;
+	preview.gain = jlimit( 0.f, 1.f, preview.gain + gainStep * numSamples );
+	if( source == nullptr || source->getNumChannels() == 0 || source->getNumSamples() == 0 ){
+		return;
+	}
+	// chunks between loop wraps, ramps only while the gain moves
+	const auto isRamping = gainStart != preview.gain;
+	for( int done = 0; done < numSamples; ){
+		if( preview.position >= source->getNumSamples() ){
+			if( !preview.isLooping ){
+				return;
+			}
+			preview.position = 0;
+		}
+		const auto len = jmin( numSamples - done, source->getNumSamples() - preview.position );
+		for( int ch = 0; ch < numChannels; ++ch ){
+			auto* write = output[ ch ];
+			if( write == nullptr ){
+				continue;
+			}
+			write += done;
+			const auto* read = source->getReadPointer( ch % source->getNumChannels(), preview.position );
+			if( !isRamping ){
+				FloatVectorOperations::addWithMultiply( write, read, gainStart, len );
+				continue;
+			}
+			for( int i = 0; i < len; ++i ){
+				write[ i ] += read[ i ] * jlimit( 0.f, 1.f, gainStart + ( done + i ) * gainStep );
+			}
+		}
+		preview.position += len;
+		done += len;
+	}
+}
+
+void aud::PreviewPlayer::retire( Preview* preview )
+{
+	int start1, size1, start2, size2;
+	retiredFifo.prepareToWrite( 1, start1, size1, start2, size2 );
+	if( size1 == 0 ){
+		// message thread stalled for long, better to leak than to free here
+		jassertfalse;
+		return;
+	}
+	retired[ start1 ] = preview;
+	retiredFifo.finishedWrite( 1 );
+}
+
+// PreviewPlayer - Timer
+void aud::PreviewPlayer::timerCallback()
+{
+	while( retiredFifo.getNumReady() > 0 ){
+		int start1, size1, start2, size2;
+		retiredFifo.prepareToRead( 1, start1, size1, start2, size2 );
+		delete retired[ start1 ];
+		retiredFifo.finishedRead( 1 );
+	}
+}
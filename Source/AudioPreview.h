@@ -0,0 +1,59 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+namespace aud
+{
+	/// Plays one buffer at a time for auditioning. New buffers are handed to the audio thread by atomic exchange,
+	/// replaced ones are handed back through a fifo and freed on the message thread. Switching crossfades shortly.
+	class PreviewPlayer : public AudioIODeviceCallback,
+		private Timer
+	{
+	public:
+		/// Samples of the de-click fade between previews.
+		static const int DeclickLength = 128;
+
+		PreviewPlayer();
+		~PreviewPlayer();
+
+		// modify
+		/// Takes ownership of buffer, nullptr fades out the current one. Call from the message thread.
+		void play( AudioBuffer<float>* buffer, bool shouldLoop );
+		void stop(){ play( nullptr, false ); }
+
+		// AudioIODeviceCallback
+		void audioDeviceIOCallback( const float** inputChannelData, int numInputChannels, float** outputChannelData, int numOutputChannels, int numSamples )override;
+		void audioDeviceAboutToStart( AudioIODevice* device )override;
+		void audioDeviceStopped()override;
+
+	private:
+		struct Preview
+		{
+			std::unique_ptr<AudioBuffer<float>> buffer;
+			bool isLooping = false;
+			int position = 0;
+			float gain = 0.f;
+		};
+
+		// process
+		/// Adds preview to output, with a gain ramp by gainStep per sample.
+		void addPreview( Preview& preview, float* const* output, int numChannels, int numSamples, float gainStep );
+
+		/// Hands preview to the message thread.
+		void retire( Preview* preview );
+
+		// Timer
+		void timerCallback()override;
+
+		std::atomic<Preview*> pending{ nullptr };
+		Preview* current = nullptr; // audio thread only
+		Preview* fading = nullptr; // audio thread only
+
+		static const int NumRetired = 128;
+		AbstractFifo retiredFifo{ NumRetired };
+		std::array<Preview*, NumRetired> retired{};
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( PreviewPlayer );
+	};
+}
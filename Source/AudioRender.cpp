@@ -0,0 +1,351 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioRender.h"
+
+#include "AudioHash.h"
+
+using namespace unc;
+
+// createRenderJobs
+RenderJobs unc::createRenderJobs( const AudioClips& clips, const File& outDir )
+{
+	RenderJobs ret;
+	for( int clipIdx = 0; clipIdx < clips.size(); ++clipIdx ){
+		auto* clip = clips.get( clipIdx );
+		for( int zoneIdx = 0; zoneIdx < clip->sizeZones(); ++zoneIdx ){
+			String name;
+			name << clip->getName() << "_";
+			if( clip->pitch.hasRootNote() ){
+				name << clip->pitch.getRootNoteName() << "_";
+			}
+			name << zoneIdx << "_" << clip->getZone( zoneIdx ).name << ".wav";
+			ret.push_back( { clip, zoneIdx, outDir.getChildFile( name ) } );
+		}
+	}
+	return ret;
+}
+
+// parseRenderSettings
+/// \returns lower case value following option on the command line, empty if missing.
+String getRenderOption( const StringArray& args, const String& option )
+{
+	auto index = args.indexOf( option );
+	if( index < 0 || index + 1 >= args.size() || args[ index + 1 ].startsWith( "--" ) ){
+		return String();
+	}
+	return args[ index + 1 ].unquoted().toLowerCase();
+}
+
+Result unc::parseRenderSettings( const StringArray& args, RenderSettings& settings )
+{
+	auto& output = settings.output;
+	const auto format = getRenderOption( args, "--format" );
+	if( format.isNotEmpty() ){
+		int i = 0;
+		while( i < ( int )aud::FileFormat::NumFormats && aud::toString( static_cast< aud::FileFormat >( i ) ).toLowerCase() != format ){
+			++i;
+		}
+		if( i == ( int )aud::FileFormat::NumFormats ){
+			return Result::fail( "Invalid --format " + format );
+		}
+		output.format = static_cast< aud::FileFormat >( i );
+	}
+	const auto bits = getRenderOption( args, "--bits" );
+	if( bits.isNotEmpty() ){
+		if( bits != "16" && bits != "24" && bits != "32" ){
+			return Result::fail( "Invalid --bits " + bits );
+		}
+		output.bitsPerSample = bits.getIntValue();
+	}
+	output.dither = output.dither && !args.contains( "--no-dither" );
+	output.noiseShaping = output.noiseShaping || args.contains( "--noise-shaping" );
+
+	auto& normalization = settings.normalization;
+	const auto normalize = getRenderOption( args, "--normalize" );
+	if( normalize == "peak" ){
+		normalization.mode = aud::Normalization::Peak;
+	}
+	else if( normalize == "loudness" ){
+		normalization.mode = aud::Normalization::Integrated;
+	}
+	else if( normalize.isNotEmpty() ){
+		return Result::fail( "Invalid --normalize " + normalize );
+	}
+	const auto link = getRenderOption( args, "--link" );
+	if( link == "file" ){
+		normalization.link = aud::Normalization::PerFile;
+	}
+	else if( link == "clip" ){
+		normalization.link = aud::Normalization::PerClip;
+	}
+	else if( link == "batch" ){
+		normalization.link = aud::Normalization::PerBatch;
+	}
+	else if( link.isNotEmpty() ){
+		return Result::fail( "Invalid --link " + link );
+	}
+	settings.isLoopBaked = settings.isLoopBaked && !args.contains( "--loop-markers" );
+	return Result::ok();
+}
+
+// RenderJournal
+File unc::getRenderJournalFor( const File& outDir )
+{
+	return outDir.getSiblingFile( outDir.getFileName() + ".journal" );
+}
+
+String unc::getJournalEntry( const RenderJob& job, const RenderSettings& settings, float gain )
+{
+	const auto zone = job.clip->getZone( job.zoneIndex );
+	const auto& normalization = settings.normalization;
+	const auto& output = settings.output;
+	String state;
+	state << job.clip->file.getFullPathName() << " " << String::toHexString( ( int64 )job.clip->contentHash ) << " " << job.clip->sampleRate
+		<< " " << zone.start << " " << zone.length << " " << zone.fadeIn << " " << zone.fadeOut << " " << toString( zone.mode ) << " " << zone.name
+		<< " " << ( int )settings.isLoopBaked << " " << job.clip->pitch.getRootNote()
+		<< " " << aud::toString( output.format ) << " " << output.bitsPerSample << " " << ( int )output.dither << " " << ( int )output.noiseShaping
+		<< " " << ( int )normalization.mode << " " << ( int )normalization.link << " " << normalization.peakTarget
+		<< " " << normalization.loudnessTarget << " " << normalization.truePeakCeiling << " " << gain;
+	return String::toHexString( state.hashCode64() ) + " " + job.target.withFileExtension( output.getFileExtension() ).getFileName();
+}
+
+unc::RenderJournal::RenderJournal( const File& file_ ) :
+	file( file_ )
+{
+	if( !file.existsAsFile() ){
+		return;
+	}
+	// a line torn by a crash never matches an entry
+	const auto text = file.loadFileAsString();
+	endsTorn = text.isNotEmpty() && !text.endsWithChar( '\n' );
+	StringArray lines;
+	lines.addLines( text );
+	for( const auto& line : lines ){
+		entries.insert( line );
+	}
+}
+
+bool unc::RenderJournal::add( const String& entry )
+{
+	if( file == File() ){
+		return true;
+	}
+	const ScopedLock lock( writeLock );
+	if( stream == nullptr ){
+		// appends to existing entries
+		stream.reset( file.createOutputStream() );
+		if( stream == nullptr ){
+			return false;
+		}
+		if( endsTorn ){
+			stream->writeText( "\n", false, false, nullptr );
+		}
+	}
+	stream->writeText( entry + "\n", false, false, nullptr );
+	stream->flush();
+	return stream->getStatus().wasOk();
+}
+
+// getSampleMetadata
+aud::SampleMetadata unc::getSampleMetadata( const RenderJob& job, const RenderSettings& settings )
+{
+	const auto zone = job.clip->getZone( job.zoneIndex );
+	aud::SampleMetadata ret;
+	ret.name = zone.name;
+	ret.rootNote = job.clip->pitch.hasRootNote() ? job.clip->pitch.getRootNote() : -1;
+	if( zone.mode == AudioPlayMode::Loop ){
+		ret.loopStart = zone.getRenderedLoopStart( settings.isLoopBaked );
+		ret.loopEnd = zone.getRenderedLength( settings.isLoopBaked ) - 1;
+	}
+	return ret;
+}
+
+// measureLinkedGains
+std::vector<float> unc::measureLinkedGains( const RenderJobs& jobs, const RenderSettings& settings )
+{
+	const auto& normalization = settings.normalization;
+	std::vector<float> gains( jobs.size(), 1.f );
+	aud::parallelFor( ( int )jobs.size(), [ & ]( int i ){
+		if( settings.cancel.isCancelled() ){
+			return;
+		}
+		UNC_TRACE_JOB( i );
+		std::unique_ptr<AudioBuffer<float>> buf( jobs[ i ].clip->writeAudio( jobs[ i ].zoneIndex, settings.isLoopBaked ) );
+		if( buf ){
+			auto loudness = aud::measureLoudness( *buf, jobs[ i ].clip->sampleRate );
+			gains[ i ] = aud::getNormalizationGain( loudness, normalization );
+		}
+	}, JobPriority::Batch );
+	// groups are keyed by clip, or share one key for the whole batch
+	auto groupOf = [ & ]( size_t i ){
+		return normalization.link == aud::Normalization::PerClip ? jobs[ i ].clip : nullptr;
+	};
+	std::map<AudioClip*, float> groupGains;
+	for( size_t i = 0; i < jobs.size(); ++i ){
+		auto it = groupGains.find( groupOf( i ) );
+		if( it == groupGains.end() ){
+			groupGains[ groupOf( i ) ] = gains[ i ];
+		}
+		else{
+			it->second = jmin( it->second, gains[ i ] );
+		}
+	}
+	for( size_t i = 0; i < jobs.size(); ++i ){
+		gains[ i ] = groupGains[ groupOf( i ) ];
+	}
+	return gains;
+}
+
+std::vector<float> unc::getLinkedGains( const RenderJobs& jobs, const RenderSettings& settings )
+{
+	if( settings.linkedGains.size() == jobs.size() ){
+		return settings.linkedGains;
+	}
+	if( settings.normalization.link == aud::Normalization::PerBatch && settings.batchGain > 0.f ){
+		return std::vector<float>( jobs.size(), settings.batchGain );
+	}
+	return measureLinkedGains( jobs, settings );
+}
+
+// render
+Result unc::render( const RenderJobs& jobs, const RenderSettings& settings )
+{
+	clearTrace();
+	AllocationCounter allocations;
+	const auto start = Time::getMillisecondCounterHiRes();
+	const auto& normalization = settings.normalization;
+	const auto isLinked = normalization.isActive() && normalization.link != aud::Normalization::PerFile;
+
+	// linked gains need all measurements before the first write, measure in memory only
+	const auto linkedGains = isLinked ? getLinkedGains( jobs, settings ) : std::vector<float>();
+	// every job renders, gains and encodes on its own, memory is bound by the number of workers
+	// disk writes of all jobs go through one thread, so rendering continues while files are written
+	TimeSliceThread ioThread( "Render Writer" );
+	ioThread.startThread();
+	String err;
+	CriticalSection errLock;
+
+	// files replace their targets only once complete and synced, the journal records them after, so a resumed render redoes only unfinished jobs
+	// temporary files of an interrupted render are never reused
+	Array<File> targets;
+	for( const auto& job : jobs ){
+		targets.add( job.target.withFileExtension( settings.output.getFileExtension() ) );
+	}
+	aud::removeTemporaryFiles( targets );
+	RenderJournal journal( settings.journal );
+	std::atomic<int> numSkipped{ 0 };
+	aud::parallelFor( ( int )jobs.size(), [ & ]( int i ){
+		if( settings.cancel.isCancelled() ){
+			return;
+		}
+		UNC_TRACE_JOB( i );
+		const auto& job = jobs[ i ];
+		const auto entry = getJournalEntry( job, settings, isLinked ? linkedGains[ i ] : 1.f );
+		if( journal.contains( entry ) && job.target.withFileExtension( settings.output.getFileExtension() ).existsAsFile() ){
+			++numSkipped;
+			return;
+		}
+		std::unique_ptr<AudioBuffer<float>> buf( job.clip->writeAudio( job.zoneIndex, settings.isLoopBaked ) );
+		if( !buf ){
+			const ScopedLock lock( errLock );
+			err << "unc::render() Error rendering " << job.target.getFileName() << newLine;
+			return;
+		}
+		// gain stage
+		if( isLinked ){
+			UNC_TRACE_SCOPE( "gain" );
+			buf->applyGain( linkedGains[ i ] );
+		}
+		else if( normalization.isActive() ){
+			auto gain = aud::getNormalizationGain( aud::measureLoudness( *buf, job.clip->sampleRate ), normalization );
+			UNC_TRACE_SCOPE( "gain" );
+			buf->applyGain( gain );
+		}
+		// write
+		if( job.target.getParentDirectory().createDirectory().failed() || !aud::writeToFile( job.target, *buf, job.clip->sampleRate, settings.output, &ioThread,
+			aud::createWriterMetadata( getSampleMetadata( job, settings ), job.clip->sampleRate, settings.output.format ) ) ){
+			const ScopedLock lock( errLock );
+			err << "unc::render() Error writing " << job.target.getFullPathName() << newLine;
+		}
+		else if( !journal.add( entry ) ){
+			const ScopedLock lock( errLock );
+			err << "unc::render() Error writing journal " << settings.journal.getFullPathName() << newLine;
+		}
+	}, JobPriority::Batch );
+	ioThread.stopThread( -1 );
+	if( settings.cancel.isCancelled() ){
+		err << "unc::render() Cancelled, rendering again resumes with the missing files" << newLine;
+	}
+
+	// stages of all jobs, disk writes overlap with the others
+	String summary;
+	summary << "unc::render() " << ( int )jobs.size() - numSkipped << " files, " << numSkipped.load() << " resumed, in " << String( ( Time::getMillisecondCounterHiRes() - start ) / 1000., 2 ) << " s, "
+		<< allocations.getNumAllocations() << " process allocations" << newLine << getTraceSummary();
+	Logger::writeToLog( summary );
+	return err.isEmpty() ? Result::ok() : Result::fail( err );
+}
+
+// verifyDeterminism
+std::vector<uint64> unc::hashRenderJobs( const RenderJobs& jobs, const RenderSettings& settings, bool isSerial )
+{
+	std::vector<uint64> ret( jobs.size(), 0 );
+	auto hashJob = [ & ]( int i ){
+		std::unique_ptr<AudioBuffer<float>> buf( jobs[ i ].clip->writeAudio( jobs[ i ].zoneIndex, settings.isLoopBaked ) );
+		if( buf ){
+			ret[ i ] = aud::hashBuffer( *buf );
+		}
+	};
+	if( isSerial ){
+		for( int i = ( int )jobs.size() - 1; i >= 0; --i ){
+			hashJob( i );
+		}
+	}
+	else{
+		aud::parallelFor( ( int )jobs.size(), hashJob, JobPriority::Batch );
+	}
+	return ret;
+}
+
+Result unc::verifyDeterminism( const RenderJobs& jobs, const RenderSettings& settings, StringArray& hashes )
+{
+	const auto serialAudio = hashRenderJobs( jobs, settings, true );
+	const auto parallelAudio = hashRenderJobs( jobs, settings, false );
+
+	// files of both runs get equal names, dither is seeded by them
+	const auto root = File::getSpecialLocation( File::tempDirectory ).getNonexistentChildFile( "UnicycleVerify", "" );
+	auto retarget = [ & ]( const String& folder ){
+		auto ret = jobs;
+		for( auto& job : ret ){
+			job.target = root.getChildFile( folder ).getChildFile( job.target.getFileName() );
+		}
+		return ret;
+	};
+	const auto narrowJobs = retarget( "narrow" );
+	const auto wideJobs = retarget( "wide" );
+	auto verifySettings = settings;
+	verifySettings.journal = File();
+	auto* scheduler = getJobScheduler();
+	const auto maxBatch = scheduler->getMaxConcurrency( JobPriority::Batch );
+	scheduler->setMaxConcurrency( JobPriority::Batch, 1 );
+	auto narrow = render( narrowJobs, verifySettings );
+	scheduler->setMaxConcurrency( JobPriority::Batch, maxBatch );
+	auto wide = render( wideJobs, verifySettings );
+
+	String err;
+	if( narrow.failed() || wide.failed() ){
+		err << narrow.getErrorMessage() << wide.getErrorMessage();
+	}
+	const auto extension = settings.output.getFileExtension();
+	for( size_t i = 0; i < jobs.size(); ++i ){
+		const auto fileHash = aud::hashFile( narrowJobs[ i ].target.withFileExtension( extension ) );
+		const auto name = jobs[ i ].target.withFileExtension( extension ).getFileName();
+		hashes.add( String::toHexString( ( int64 )serialAudio[ i ] ).paddedLeft( '0', 16 ) + " " + String::toHexString( ( int64 )fileHash ).paddedLeft( '0', 16 ) + " " + name );
+		if( serialAudio[ i ] != parallelAudio[ i ] ){
+			err << "unc::verifyDeterminism() Audio differs " << name << newLine;
+		}
+		if( fileHash != aud::hashFile( wideJobs[ i ].target.withFileExtension( extension ) ) ){
+			err << "unc::verifyDeterminism() File differs " << name << newLine;
+		}
+	}
+	root.deleteRecursively();
+	return err.isEmpty() ? Result::ok() : Result::fail( err );
+}
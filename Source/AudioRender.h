@@ -0,0 +1,105 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include "AudioAnalysis.h"
+#include "AudioOutput.h"
+#include "AudioClip.h"
+
+namespace unc
+{
+	/// One zone of one clip, rendered to one file.
+	struct RenderJob
+	{
+		AudioClip* clip = nullptr;
+		int zoneIndex = 0;
+		File target;
+	};
+	using RenderJobs = std::vector<RenderJob>;
+
+	/// \returns a job for every zone of every clip, writing into outDir.
+	RenderJobs createRenderJobs( const AudioClips& clips, const File& outDir );
+
+	struct RenderSettings
+	{
+		aud::Normalization normalization;
+		aud::OutputFormat output;
+
+		/// Finished jobs are recorded here, jobs recorded with equal settings whose file exists are skipped.
+		/// Nothing is recorded if it is File().
+		File journal;
+
+		/// Gain of a batch linked render measured beforehand, e.g. across shards, 0 measures it.
+		float batchGain = 0.f;
+
+		/// Crossfades the end of loop zones into their start, otherwise writes them untouched and players loop at their markers only.
+		bool isLoopBaked = true;
+
+		/// Linked gain of every job measured beforehand, e.g. by a measure job the render runs after, empty measures them.
+		std::vector<float> linkedGains;
+
+		/// Stops the render, jobs not yet started are skipped, finished files stay and are journaled.
+		CancelToken cancel;
+	};
+
+	/// Sets what the command line options give, leaving the rest of settings:
+	/// --format wav|aiff|flac --bits 16|24|32 --no-dither --noise-shaping --normalize peak|loudness --link file|clip|batch --loop-markers
+	/// \returns fail naming the first invalid option.
+	Result parseRenderSettings( const StringArray& args, RenderSettings& settings );
+
+	/// Measures all jobs in parallel and returns the gain of each, linked jobs get the smallest gain of their group.
+	std::vector<float> measureLinkedGains( const RenderJobs& jobs, const RenderSettings& settings );
+
+	/// \returns gain of every job of a linked render, from settings.linkedGains or settings.batchGain if given, measured otherwise.
+	std::vector<float> getLinkedGains( const RenderJobs& jobs, const RenderSettings& settings );
+
+	/// \returns zone name, root note and loop markers of the file of job.
+	aud::SampleMetadata getSampleMetadata( const RenderJob& job, const RenderSettings& settings );
+
+	/// \returns the journal kept next to outDir.
+	File getRenderJournalFor( const File& outDir );
+
+	/// \returns the journal line of job, which changes with anything its output depends on.
+	/// \param gain is the linked normalization gain, 1 if unlinked.
+	String getJournalEntry( const RenderJob& job, const RenderSettings& settings, float gain );
+
+	/// Append only record of finished jobs, so an interrupted render resumes with the jobs that did not complete.
+	class RenderJournal
+	{
+	public:
+		/// Reads the entries of file, which is created by the first add().
+		RenderJournal( const File& file );
+
+		// modify
+		/// Appends entry and flushes it to disk, thread safe.
+		/// \returns false if the journal could not be written.
+		bool add( const String& entry );
+
+		// access
+		bool contains( const String& entry ) const{ return entries.count( entry ) > 0; }
+
+	private:
+		File file;
+		std::set<String> entries;
+		std::unique_ptr<FileOutputStream> stream;
+		bool endsTorn = false;
+		CriticalSection writeLock;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( RenderJournal );
+	};
+
+	/// Renders, normalizes, encodes and writes all jobs on worker threads, every file is written exactly once.
+	/// Files appear complete or not at all, jobs finished by an earlier render in settings.journal are skipped.
+	/// Temporary files an interrupted render left next to the targets are deleted first.
+	Result render( const RenderJobs& jobs, const RenderSettings& settings );
+
+	/// \returns hash of the audio of every job, see aud::hashBuffer(), 0 if it failed.
+	/// \param isSerial renders on the calling thread in reverse job order, otherwise on all workers.
+	std::vector<uint64> hashRenderJobs( const RenderJobs& jobs, const RenderSettings& settings, bool isSerial );
+
+	/// Renders jobs serially in reverse order and on all workers, then writes their files once on one worker and once on all.
+	/// \param hashes receives an audio hash, file hash and file name per job, for comparing against golden renders.
+	/// \returns ok if audio and files of both runs are bit identical, otherwise the jobs that differ.
+	Result verifyDeterminism( const RenderJobs& jobs, const RenderSettings& settings, StringArray& hashes );
+}
@@ -0,0 +1,315 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioRenderShards.h"
+
+using namespace unc;
+
+// how often the coordinator looks for manifests of workers started elsewhere
+const static int ManifestPollMs( 500 );
+
+// assignShards
+std::vector<int> unc::assignShards( const std::vector<int64>& clipLengths, int numShards )
+{
+	// ties keep clip order, so the result only depends on the lengths
+	std::vector<int> order( clipLengths.size() );
+	std::iota( order.begin(), order.end(), 0 );
+	std::stable_sort( order.begin(), order.end(), [ & ]( int a, int b ){
+		return clipLengths[ ( size_t )a ] > clipLengths[ ( size_t )b ];
+	} );
+	std::vector<int64> loads( ( size_t )jmax( 1, numShards ), 0 );
+	std::vector<int> ret( clipLengths.size(), 0 );
+	for( auto clip : order ){
+		const auto shard = std::min_element( loads.begin(), loads.end() ) - loads.begin();
+		ret[ ( size_t )clip ] = ( int )shard;
+		loads[ ( size_t )shard ] += clipLengths[ ( size_t )clip ];
+	}
+	return ret;
+}
+
+// renderSharded - spec
+/// Spec, journals and manifests of all shards, kept next to outDir.
+File getShardFolderFor( const File& outDir )
+{
+	return outDir.getSiblingFile( outDir.getFileName() + ".shards" );
+}
+
+void writeSettings( const RenderSettings& settings, XmlElement* xml )
+{
+	const auto& normalization = settings.normalization;
+	xml->setAttribute( "normalization", ( int )normalization.mode );
+	xml->setAttribute( "link", ( int )normalization.link );
+	xml->setAttribute( "peakTarget", normalization.peakTarget );
+	xml->setAttribute( "loudnessTarget", normalization.loudnessTarget );
+	xml->setAttribute( "truePeakCeiling", normalization.truePeakCeiling );
+	xml->setAttribute( "batchGain", settings.batchGain );
+	xml->setAttribute( "isLoopBaked", settings.isLoopBaked );
+	const auto& output = settings.output;
+	xml->setAttribute( "format", ( int )output.format );
+	xml->setAttribute( "bitsPerSample", output.bitsPerSample );
+	xml->setAttribute( "dither", output.dither );
+	xml->setAttribute( "noiseShaping", output.noiseShaping );
+}
+
+RenderSettings readSettings( XmlElement* xml )
+{
+	RenderSettings ret;
+	auto& normalization = ret.normalization;
+	normalization.mode = static_cast< aud::Normalization::Mode >( xml->getIntAttribute( "normalization" ) );
+	normalization.link = static_cast< aud::Normalization::Link >( xml->getIntAttribute( "link" ) );
+	normalization.peakTarget = ( float )xml->getDoubleAttribute( "peakTarget", normalization.peakTarget );
+	normalization.loudnessTarget = ( float )xml->getDoubleAttribute( "loudnessTarget", normalization.loudnessTarget );
+	normalization.truePeakCeiling = ( float )xml->getDoubleAttribute( "truePeakCeiling", normalization.truePeakCeiling );
+	ret.batchGain = ( float )xml->getDoubleAttribute( "batchGain" );
+	ret.isLoopBaked = xml->getBoolAttribute( "isLoopBaked", ret.isLoopBaked );
+	auto& output = ret.output;
+	output.format = static_cast< aud::FileFormat >( xml->getIntAttribute( "format" ) );
+	output.bitsPerSample = xml->getIntAttribute( "bitsPerSample", output.bitsPerSample );
+	output.dither = xml->getBoolAttribute( "dither", output.dither );
+	output.noiseShaping = xml->getBoolAttribute( "noiseShaping", output.noiseShaping );
+	return ret;
+}
+
+/// Writes xml under a temporary name first and syncs it, so readers never see it partly written.
+bool writeAtomically( const XmlElement& xml, const File& file )
+{
+	TemporaryFile temp( file );
+	return xml.writeToFile( temp.getFile(), String() ) && aud::syncToDisk( temp.getFile() ) && temp.overwriteTargetFileWithTemporary();
+}
+
+Result writeSpec( const AudioClips& clips, const File& outDir, const RenderSettings& settings, const File& spec )
+{
+	// clip files are stored relative to the working directory, workers resolve them from there
+	XmlElement xml( "RenderSpec" );
+	xml.setAttribute( "baseDir", File::getCurrentWorkingDirectory().getFullPathName() );
+	xml.setAttribute( "outDir", outDir.getFullPathName() );
+	writeSettings( settings, xml.createNewChildElement( "RenderSettings" ) );
+	auto res = clips.toXml( xml.createNewChildElement( "AudioClips" ) );
+	if( res.failed() ){
+		return res;
+	}
+	return writeAtomically( xml, spec ) ? Result::ok() : Result::fail( "unc::renderSharded() Error writing " + spec.getFullPathName() );
+}
+
+// renderSharded - workers
+/// Waits for the manifest of a worker started elsewhere.
+/// \param timeoutMs -1 waits forever.
+bool waitForManifest( const File& manifest, int timeoutMs )
+{
+	const auto end = Time::getMillisecondCounter() + ( uint32 )jmax( 0, timeoutMs );
+	while( !manifest.existsAsFile() ){
+		if( timeoutMs >= 0 && Time::getMillisecondCounter() >= end ){
+			return false;
+		}
+		Thread::sleep( ManifestPollMs );
+	}
+	return true;
+}
+
+/// Runs one phase on all shards at once, failed shards run again.
+/// \param manifests receives the manifest of every shard, in order of shards.
+Result runShards( const File& spec, const File& folder, bool isMeasuring, const ShardSettings& shards, OwnedArray<XmlElement>& manifests )
+{
+	auto getManifest = [ & ]( int shard ){
+		return folder.getChildFile( String( isMeasuring ? "measure-" : "render-" ) + String( shard ) + ".xml" );
+	};
+	Array<int> pending;
+	manifests.clear();
+	for( int shard = 0; shard < shards.numShards; ++shard ){
+		getManifest( shard ).deleteFile();
+		pending.add( shard );
+		manifests.add( nullptr );
+	}
+	// local workers share the cores
+	const auto numJobs = String( jmax( 1, SystemStats::getNumCpus() / shards.numShards ) );
+	const auto numAttempts = shards.launchWorkers ? jmax( 1, shards.maxAttempts ) : 1;
+	for( int attempt = 0; attempt < numAttempts && !pending.isEmpty(); ++attempt ){
+		OwnedArray<ChildProcess> processes;
+		if( shards.launchWorkers ){
+			for( auto shard : pending ){
+				// a manifest of an earlier attempt must not count for this one
+				getManifest( shard ).deleteFile();
+				auto args = getShardArguments( spec, shard, shards.numShards, isMeasuring, getManifest( shard ) );
+				args.insert( 0, File::getSpecialLocation( File::currentExecutableFile ).getFullPathName() );
+				args.add( "--jobs" );
+				args.add( numJobs );
+				processes.add( new ChildProcess() )->start( args, 0 );
+			}
+		}
+		else{
+			// arguments to start them with
+			for( auto shard : pending ){
+				auto args = getShardArguments( spec, shard, shards.numShards, isMeasuring, getManifest( shard ) );
+				for( auto& arg : args ){
+					arg = arg.containsChar( ' ' ) ? arg.quoted() : arg;
+				}
+				Logger::writeToLog( "unc::renderSharded() Waiting for worker " + args.joinIntoString( " " ) );
+			}
+		}
+		// the shards of an attempt run at once, so they share one deadline
+		const auto deadline = Time::getMillisecondCounter() + ( uint32 )jmax( 0, shards.timeoutSeconds ) * 1000;
+		auto getRemainingMs = [ & ](){
+			return shards.timeoutSeconds > 0 ? ( int )jmax( ( int64 )0, ( int64 )deadline - ( int64 )Time::getMillisecondCounter() ) : -1;
+		};
+		Array<int> failed;
+		for( int i = 0; i < pending.size(); ++i ){
+			const auto shard = pending[ i ];
+			if( shards.launchWorkers ){
+				if( !processes[ i ]->waitForProcessToFinish( getRemainingMs() ) ){
+					processes[ i ]->kill();
+					failed.add( shard );
+					continue;
+				}
+			}
+			else if( !waitForManifest( getManifest( shard ), getRemainingMs() ) ){
+				failed.add( shard );
+				continue;
+			}
+			std::unique_ptr<XmlElement> manifest( XmlDocument::parse( getManifest( shard ) ) );
+			if( manifest == nullptr || manifest->getStringAttribute( "result" ) != "ok" ){
+				failed.add( shard );
+				continue;
+			}
+			manifests.set( shard, manifest.release() );
+		}
+		pending = failed;
+	}
+	if( !pending.isEmpty() ){
+		StringArray names;
+		for( auto shard : pending ){
+			names.add( String( shard ) );
+		}
+		return Result::fail( String( "unc::renderSharded() Shards " ) + names.joinIntoString( ", " ) + " failed, see " + folder.getFullPathName() );
+	}
+	return Result::ok();
+}
+
+// renderSharded
+Result unc::renderSharded( const AudioClips& clips, const File& outDir, const RenderSettings& settings, const ShardSettings& shards )
+{
+	const auto folder = getShardFolderFor( outDir );
+	const auto spec = folder.getChildFile( "spec.xml" );
+	if( shards.numShards < 1 || folder.createDirectory().failed() ){
+		return Result::fail( "unc::renderSharded() Error creating " + folder.getFullPathName() );
+	}
+	auto res = writeSpec( clips, outDir, settings, spec );
+	if( res.failed() ){
+		return res;
+	}
+	OwnedArray<XmlElement> manifests;
+
+	// a batch gain must be the same in all shards, so they measure first and all use the smallest
+	const auto& normalization = settings.normalization;
+	if( normalization.isActive() && normalization.link == aud::Normalization::PerBatch && settings.batchGain <= 0.f ){
+		res = runShards( spec, folder, true, shards, manifests );
+		if( res.failed() ){
+			return res;
+		}
+		auto measured = settings;
+		for( auto* manifest : manifests ){
+			const auto gain = ( float )manifest->getDoubleAttribute( "gain" );
+			if( gain > 0.f && ( measured.batchGain <= 0.f || gain < measured.batchGain ) ){
+				measured.batchGain = gain;
+			}
+		}
+		res = writeSpec( clips, outDir, measured, spec );
+		if( res.failed() ){
+			return res;
+		}
+	}
+	res = runShards( spec, folder, false, shards, manifests );
+	if( res.failed() ){
+		return res;
+	}
+	// one manifest of all files, every one must exist
+	XmlElement merged( "RenderManifest" );
+	merged.setAttribute( "numShards", shards.numShards );
+	String err;
+	for( auto* manifest : manifests ){
+		forEachXmlChildElementWithTagName( *manifest, fileXml, "File" ){
+			if( !outDir.getChildFile( fileXml->getStringAttribute( "name" ) ).existsAsFile() ){
+				err << "unc::renderSharded() Missing " << fileXml->getStringAttribute( "name" ) << newLine;
+			}
+			merged.addChildElement( new XmlElement( *fileXml ) );
+		}
+	}
+	const auto mergedFile = outDir.getSiblingFile( outDir.getFileName() + ".manifest.xml" );
+	if( !writeAtomically( merged, mergedFile ) ){
+		err << "unc::renderSharded() Error writing " << mergedFile.getFullPathName() << newLine;
+	}
+	return err.isEmpty() ? Result::ok() : Result::fail( err );
+}
+
+// runShard
+StringArray unc::getShardArguments( const File& spec, int shard, int numShards, bool isMeasuring, const File& manifest )
+{
+	return { isMeasuring ? "--measure-shard" : "--render-shard", String( shard ) + "/" + String( numShards ),
+		"--spec", spec.getFullPathName(), "--manifest", manifest.getFullPathName() };
+}
+
+Result unc::runShard( const File& specFile, int shard, int numShards, bool isMeasuring, const File& manifestFile )
+{
+	std::unique_ptr<XmlElement> spec( XmlDocument::parse( specFile ) );
+	if( spec == nullptr || !isPositiveAndBelow( shard, numShards ) || spec->getChildByName( "AudioClips" ) == nullptr || spec->getChildByName( "RenderSettings" ) == nullptr ){
+		return Result::fail( "unc::runShard() Invalid spec " + specFile.getFullPathName() );
+	}
+	File( spec->getStringAttribute( "baseDir" ) ).setAsCurrentWorkingDirectory();
+	const auto outDir = File( spec->getStringAttribute( "outDir" ) );
+	auto settings = readSettings( spec->getChildByName( "RenderSettings" ) );
+
+	// a retried shard resumes from its own journal
+	settings.journal = getShardFolderFor( outDir ).getChildFile( "render-" + String( shard ) + "-of-" + String( numShards ) + ".journal" );
+
+	// shards are assigned from the zones in the spec, so only the clips of this shard get decoded
+	std::vector<XmlElement*> clipXmls;
+	std::vector<int64> clipLengths;
+	forEachXmlChildElementWithTagName( *spec->getChildByName( "AudioClips" ), clipXml, "AudioClip" ){
+		int64 length = 1;
+		forEachXmlChildElementWithTagName( *clipXml, zoneXml, "AudioPlayZone" ){
+			AudioPlayZone zone;
+			zone.fromXml( zoneXml );
+			length += zone.length;
+		}
+		clipXmls.push_back( clipXml );
+		clipLengths.push_back( length );
+	}
+	const auto shardOfClip = assignShards( clipLengths, numShards );
+	AudioClips clips;
+	for( size_t i = 0; i < clipXmls.size(); ++i ){
+		if( shardOfClip[ i ] != shard ){
+			continue;
+		}
+		auto clip = createAudioClip();
+		auto parsed = clip->fromXml( clipXmls[ i ] );
+		if( parsed.failed() ){
+			return parsed;
+		}
+		clips.add( clip );
+	}
+	const auto jobs = createRenderJobs( clips, outDir );
+
+	// manifest
+	XmlElement manifest( "RenderManifest" );
+	manifest.setAttribute( "shard", shard );
+	manifest.setAttribute( "numShards", numShards );
+	auto res = Result::ok();
+	if( isMeasuring ){
+		const auto gains = measureLinkedGains( jobs, settings );
+		manifest.setAttribute( "gain", gains.empty() ? 0. : gains.front() );
+	}
+	else{
+		res = outDir.createDirectory();
+		if( res.wasOk() ){
+			res = render( jobs, settings );
+		}
+		for( const auto& job : jobs ){
+			const auto file = job.target.withFileExtension( settings.output.getFileExtension() );
+			auto* fileXml = manifest.createNewChildElement( "File" );
+			fileXml->setAttribute( "name", file.getFileName() );
+			fileXml->setAttribute( "size", String( file.getSize() ) );
+		}
+	}
+	manifest.setAttribute( "result", res.wasOk() ? "ok" : res.getErrorMessage() );
+	if( !writeAtomically( manifest, manifestFile ) ){
+		return Result::fail( "unc::runShard() Error writing " + manifestFile.getFullPathName() );
+	}
+	return res;
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include "AudioRender.h"
+
+namespace unc
+{
+	/// How a render is split across worker processes.
+	struct ShardSettings
+	{
+		int numShards = 2;
+
+		/// Failed shards run again until they succeed or all attempts are used.
+		int maxAttempts = 3;
+
+		/// Starts workers as local processes, otherwise waits for workers started elsewhere with getShardArguments().
+		bool launchWorkers = true;
+
+		/// How long the shards of an attempt may take, 0 waits forever.
+		/// Local workers still running then are killed and count as failed, as do workers started elsewhere without a manifest.
+		int timeoutSeconds = 0;
+	};
+
+	/// \returns shard of every clip, the longest clips go first to the least loaded shard.
+	/// Every process computes the same for equal clip lengths, whole clips stay in one shard so clip linked gains still hold.
+	std::vector<int> assignShards( const std::vector<int64>& clipLengths, int numShards );
+
+	/// Renders clips to outDir in worker processes, each rendering one shard, and merges their manifests next to outDir.
+	/// Batch linked normalization is measured by all shards first, their smallest gain is used by all.
+	Result renderSharded( const AudioClips& clips, const File& outDir, const RenderSettings& settings, const ShardSettings& shards );
+
+	/// \returns command line arguments of a worker for shard of spec, on this or any machine sharing the file system.
+	StringArray getShardArguments( const File& spec, int shard, int numShards, bool isMeasuring, const File& manifest );
+
+	/// Worker side, renders or only measures the clips of shard in spec and writes what it did to manifest.
+	Result runShard( const File& spec, int shard, int numShards, bool isMeasuring, const File& manifest );
+}
@@ -0,0 +1,306 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "AudioClip.h"
+#include "AudioPack.h"
+#include "AudioRender.h"
+#include "AudioRenderShards.h"
+
+namespace unc
+{
+	class AudioRenderTest : public UnitTest
+	{
+	public:
+		AudioRenderTest() : UnitTest( "AudioRenderTest" ){}
+
+		void runTest() override
+		{
+			testRenderResume();
+			testAssignShards();
+			testRenderShards();
+			testShardSettings();
+			testDeterminism();
+			testRenderPack();
+			testPackKeys();
+			testLoopMetadata();
+		}
+
+		/// \returns clip of a sine on every channel, frequency in radians per sample.
+		AudioClip::Ptr createSineClip( const String& name, int numChannels, int numSamples, float frequency )
+		{
+			AudioBuffer<float> b( numChannels, numSamples );
+			for( int ch = 0; ch < numChannels; ++ch ){
+				for( int i = 0; i < numSamples; ++i ){
+					b.setSample( ch, i, 0.5f * std::sin( frequency * i ) );
+				}
+			}
+			return createAudioClip( b, { 44100., 0, 32 }, name );
+		}
+
+		/// \returns new empty folder in the temp directory, the test deletes it.
+		File createTempFolder( const String& name )
+		{
+			auto ret = File::getSpecialLocation( File::tempDirectory ).getNonexistentChildFile( "Unicycle" + name, "" );
+			expect( ret.createDirectory().wasOk() );
+			return ret;
+		}
+
+		void testRenderResume()
+		{
+			beginTest( "testRenderResume" );
+
+			AudioClips clips;
+			auto clip = createSineClip( "resume", 1, 1000, 0.1f );
+			clip->addZone( { 0, 500, 0, 10, AudioPlayMode::Play } );
+			clip->addZone( { 500, 500, 0, 10, AudioPlayMode::Play } );
+			clips.add( clip );
+			const auto dir = createTempFolder( "Resume" );
+			const auto outDir = dir.getChildFile( "out" );
+			RenderSettings settings;
+			settings.journal = getRenderJournalFor( outDir );
+			const auto jobs = createRenderJobs( clips, outDir );
+			expect( render( jobs, settings ).wasOk() );
+			expect( jobs[ 0 ].target.existsAsFile() && jobs[ 1 ].target.existsAsFile() );
+
+			// only the missing file renders again, the recorded one is kept as is
+			jobs[ 0 ].target.deleteFile();
+			jobs[ 1 ].target.replaceWithText( "kept" );
+			expect( render( jobs, settings ).wasOk() );
+			expect( jobs[ 0 ].target.getSize() > 1000 );
+			expectEquals( jobs[ 1 ].target.loadFileAsString(), String( "kept" ) );
+
+			// changed settings render all
+			settings.output.bitsPerSample = 16;
+			expect( render( jobs, settings ).wasOk() );
+			expect( jobs[ 1 ].target.getSize() > 1000 );
+
+			dir.deleteRecursively();
+		}
+
+		void testAssignShards()
+		{
+			beginTest( "testAssignShards" );
+
+			// longest first onto the least loaded, ties to the first shard
+			expect( assignShards( { 10, 50, 30, 30, 5 }, 2 ) == std::vector<int>{ 0, 0, 1, 1, 0 } );
+			expect( assignShards( { 10, 50, 30 }, 5 ) == std::vector<int>{ 2, 0, 1 } );
+		}
+
+		void testRenderShards()
+		{
+			beginTest( "testRenderShards" );
+
+			// two clips rendered by two local worker processes
+			const auto dir = createTempFolder( "Shards" );
+			AudioClips clips;
+			for( int c = 0; c < 2; ++c ){
+				const auto file = dir.getChildFile( "clip" + String( c ) + ".wav" );
+				expect( aud::writeToFile( file, createSineClip( "shard", 1, 1000, 0.01f * ( c + 1 ) )->getAudio(), 44100., aud::OutputFormat() ) );
+				auto clip = createAudioClip( file );
+				clip->addZone( { 0, 500, 0, 10, AudioPlayMode::Play } );
+				clip->addZone( { 500, 500, 0, 10, AudioPlayMode::Loop } );
+				clips.add( clip );
+			}
+			const auto outDir = dir.getChildFile( "out" );
+			RenderSettings settings;
+			settings.normalization.mode = aud::Normalization::Peak;
+			settings.normalization.link = aud::Normalization::PerBatch;
+			expect( renderSharded( clips, outDir, settings, ShardSettings() ).wasOk() );
+			for( const auto& job : createRenderJobs( clips, outDir ) ){
+				expect( job.target.existsAsFile() );
+			}
+			std::unique_ptr<XmlElement> manifest( XmlDocument::parse( dir.getChildFile( "out.manifest.xml" ) ) );
+			expect( manifest != nullptr && manifest->getNumChildElements() == 4 );
+			dir.deleteRecursively();
+		}
+
+		void testShardSettings()
+		{
+			beginTest( "testShardSettings" );
+
+			// command line options
+			RenderSettings settings;
+			const auto args = StringArray::fromTokens( "--format flac --bits 16 --noise-shaping --normalize loudness --link clip --loop-markers", false );
+			expect( parseRenderSettings( args, settings ).wasOk() );
+			expect( settings.output.format == aud::FileFormat::Flac );
+			expectEquals( settings.output.bitsPerSample, 16 );
+			expect( settings.output.noiseShaping && settings.output.dither && !settings.isLoopBaked );
+			expect( settings.normalization.mode == aud::Normalization::Integrated && settings.normalization.link == aud::Normalization::PerClip );
+			RenderSettings invalid;
+			expect( parseRenderSettings( StringArray::fromTokens( "--bits 12", false ), invalid ).failed() );
+
+			// reach the spec of the workers, none of which starts here
+			const auto dir = createTempFolder( "ShardSettings" );
+			AudioClips clips;
+			const auto file = dir.getChildFile( "clip.wav" );
+			expect( aud::writeToFile( file, createSineClip( "shard", 1, 1000, 0.01f )->getAudio(), 44100., aud::OutputFormat() ) );
+			auto clip = createAudioClip( file );
+			clip->addZone( { 0, 500, 0, 10, AudioPlayMode::Play } );
+			clips.add( clip );
+			ShardSettings shards;
+			shards.launchWorkers = false;
+			shards.timeoutSeconds = 1;
+			expect( renderSharded( clips, dir.getChildFile( "out" ), settings, shards ).failed() );
+			std::unique_ptr<XmlElement> spec( XmlDocument::parse( dir.getChildFile( "out.shards" ).getChildFile( "spec.xml" ) ) );
+			auto* specSettings = spec != nullptr ? spec->getChildByName( "RenderSettings" ) : nullptr;
+			expect( specSettings != nullptr );
+			if( specSettings ){
+				expectEquals( specSettings->getIntAttribute( "format" ), ( int )aud::FileFormat::Flac );
+				expectEquals( specSettings->getIntAttribute( "bitsPerSample" ), 16 );
+				expect( specSettings->getBoolAttribute( "noiseShaping" ) );
+				expectEquals( specSettings->getIntAttribute( "normalization" ), ( int )aud::Normalization::Integrated );
+				expectEquals( specSettings->getIntAttribute( "link" ), ( int )aud::Normalization::PerClip );
+				expect( !specSettings->getBoolAttribute( "isLoopBaked", true ) );
+			}
+			dir.deleteRecursively();
+		}
+
+		void testDeterminism()
+		{
+			beginTest( "testDeterminism" );
+
+			// channel counts of every interpolator kernel, fades and crossfades of both shapes of zone
+			std::vector<AudioClip::Ptr> clips;
+			RenderJobs jobs;
+			for( auto numChans : { 1, 2, 3, 8 } ){
+				AudioBuffer<float> b( numChans, 5000 );
+				Random random( numChans );
+				for( int ch = 0; ch < numChans; ++ch ){
+					for( int i = 0; i < b.getNumSamples(); ++i ){
+						b.setSample( ch, i, random.nextFloat() - 0.5f );
+					}
+				}
+				auto clip = createAudioClip( b, { 44100., 0, 32 }, "determinism" + String( numChans ) );
+				clip->addZone( { 100, 2000, 300, 400, AudioPlayMode::Play } );
+				clip->addZone( { 2500, 2000, 0, 700, AudioPlayMode::Loop } );
+				for( int z = 0; z < clip->sizeZones(); ++z ){
+					jobs.push_back( { clip.get(), z, File::getSpecialLocation( File::tempDirectory ).getChildFile( clip->getName() + "_" + String( z ) + ".wav" ) } );
+				}
+				clips.push_back( clip );
+			}
+			RenderSettings settings;
+			settings.normalization.mode = aud::Normalization::Integrated;
+			settings.output.bitsPerSample = 16;
+			StringArray hashes;
+			auto res = verifyDeterminism( jobs, settings, hashes );
+			expect( res.wasOk(), res.getErrorMessage() );
+			expectEquals( hashes.size(), ( int )jobs.size() );
+		}
+
+		void testRenderPack()
+		{
+			beginTest( "testRenderPack" );
+
+			// mono clip with a one shot and a loop, stereo clip in a pack of its own
+			std::vector<AudioClip::Ptr> clips;
+			RenderJobs jobs;
+			const auto dir = createTempFolder( "Pack" );
+			for( auto numChans : { 1, 2 } ){
+				auto clip = createSineClip( "pack" + String( numChans ), numChans, 5000, 0.05f );
+				clip->addZone( { 100, 2000, 10, 10, AudioPlayMode::Play } );
+				if( numChans == 1 ){
+					clip->addZone( { 2500, 2000, 0, 700, AudioPlayMode::Loop } );
+				}
+				for( int z = 0; z < clip->sizeZones(); ++z ){
+					jobs.push_back( { clip.get(), z, dir.getChildFile( clip->getName() + "_" + String( z ) ) } );
+				}
+				clips.push_back( clip );
+			}
+			RenderSettings settings;
+			const auto sfz = dir.getChildFile( "pack.sfz" );
+			auto res = renderPack( jobs, settings, sfz );
+			expect( res.wasOk(), res.getErrorMessage() );
+
+			// regions follow each other, the loop without its crossfade
+			WavAudioFormat wav;
+			std::unique_ptr<AudioFormatReader> reader( wav.createReaderFor( dir.getChildFile( "pack_1.wav" ).createInputStream(), true ) );
+			expect( reader != nullptr );
+			if( reader ){
+				expectEquals( ( int )reader->lengthInSamples, 2000 + 1300 );
+				expectEquals( ( int )reader->numChannels, 1 );
+				expectEquals( reader->metadataValues.getValue( "NumCuePoints", "0" ), String( "2" ) );
+			}
+			expect( dir.getChildFile( "pack_2.wav" ).existsAsFile() );
+			const auto text = sfz.loadFileAsString();
+			expect( text.contains( "sample=pack_1.wav offset=2000 end=3299 key=61" ) );
+			expect( text.contains( "loop_start=2000 loop_end=3299" ) );
+			expect( text.contains( "sample=pack_2.wav offset=0 end=1999 key=62" ) );
+			dir.deleteRecursively();
+		}
+
+		void testPackKeys()
+		{
+			beginTest( "testPackKeys" );
+
+			// two clips of more zones than keys together, every region has a key and no key of a mapping plays two
+			std::vector<AudioClip::Ptr> clips;
+			RenderJobs jobs;
+			const auto dir = createTempFolder( "PackKeys" );
+			for( int c = 0; c < 2; ++c ){
+				auto clip = createSineClip( "keys" + String( c ), 1, 4000, 0.01f * ( c + 1 ) );
+				for( int z = 0; z < 40; ++z ){
+					clip->addZone( { z * 100, 100, 10, 10, AudioPlayMode::Play } );
+				}
+				for( int z = 0; z < clip->sizeZones(); ++z ){
+					jobs.push_back( { clip.get(), z, dir.getChildFile( clip->getName() + "_" + String( z ) ) } );
+				}
+				clips.push_back( clip );
+			}
+			const auto sfz = dir.getChildFile( "pack.sfz" );
+			auto res = renderPack( jobs, RenderSettings(), sfz );
+			expect( res.wasOk(), res.getErrorMessage() );
+			const auto sfzFiles = getSfzFiles( sfz, ( int )jobs.size() );
+			expectEquals( sfzFiles.size(), 2 );
+			int numRegions = 0;
+			for( const auto& file : sfzFiles ){
+				std::set<int> keys;
+				StringArray lines;
+				lines.addLines( file.loadFileAsString() );
+				for( const auto& line : lines ){
+					if( line.startsWith( "<region>" ) ){
+						expect( line.contains( " key=" ) );
+						const auto key = line.fromFirstOccurrenceOf( " key=", false, false ).getIntValue();
+						expect( keys.insert( key ).second && isPositiveAndBelow( key, 128 ) );
+						++numRegions;
+					}
+				}
+			}
+			expectEquals( numRegions, ( int )jobs.size() );
+			dir.deleteRecursively();
+		}
+
+		void testLoopMetadata()
+		{
+			beginTest( "testLoopMetadata" );
+
+			AudioClips clips;
+			auto clip = createSineClip( "loopMetadata", 1, 3000, 0.1f );
+			AudioPlayZone zone{ 500, 2000, 0, 700, AudioPlayMode::Loop };
+			zone.name = "sustain";
+			clip->addZone( zone );
+			clips.add( clip );
+			const auto dir = createTempFolder( "Loops" );
+			const auto jobs = createRenderJobs( clips, dir );
+			WavAudioFormat wav;
+
+			// baked loops loop the whole file, markers loop the untouched zone after its crossfade
+			for( auto isLoopBaked : { true, false } ){
+				RenderSettings settings;
+				settings.isLoopBaked = isLoopBaked;
+				expect( render( jobs, settings ).wasOk() );
+				std::unique_ptr<AudioFormatReader> reader( wav.createReaderFor( jobs[ 0 ].target.createInputStream(), true ) );
+				expect( reader != nullptr );
+				if( reader ){
+					const auto& metadata = reader->metadataValues;
+					expectEquals( ( int )reader->lengthInSamples, isLoopBaked ? 1300 : 2000 );
+					expectEquals( metadata.getValue( "NumSampleLoops", "0" ), String( "1" ) );
+					expectEquals( metadata.getValue( "Loop0Start", "" ), String( isLoopBaked ? 0 : 700 ) );
+					expectEquals( metadata.getValue( "Loop0End", "" ), String( isLoopBaked ? 1299 : 1999 ) );
+					expectEquals( metadata.getValue( "CueLabel0Text", "" ), String( "sustain" ) );
+				}
+			}
+			dir.deleteRecursively();
+		}
+	};
+	static AudioRenderTest audioRenderTest;
+}
@@ -0,0 +1,309 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioSampler.h"
+
+using namespace unc;
+
+// createKeyMap
+KeyMap* unc::createKeyMap( AudioClip* clip )
+{
+	auto* ret = new KeyMap();
+	if( clip == nullptr ){
+		return ret;
+	}
+	for( int z = 0; z < clip->sizeZones() && KeyMap::FirstNote + z < 128; ++z ){
+		auto& key = ret->keys[ KeyMap::FirstNote + z ];
+		key.audio.reset( clip->writeAudio( z ) );
+		key.isLooping = clip->getZone( z ).mode == AudioPlayMode::Loop;
+	}
+	return ret;
+}
+
+// ZoneSampler
+/// Voices start on this until they play a zone.
+const AudioBuffer<float>& getSilentBuffer()
+{
+	static AudioBuffer<float> ret( 1, 0 );
+	return ret;
+}
+
+unc::ZoneSampler::Voice::Voice() :
+	resampler( getSilentBuffer() )
+{}
+
+unc::ZoneSampler::ZoneSampler()
+{
+	startTimerHz( 10 );
+}
+
+unc::ZoneSampler::~ZoneSampler()
+{
+	// the device callback must be removed before
+	stopTimer();
+	timerCallback();
+	delete pendingMap.exchange( nullptr );
+	delete currentMap;
+	delete drainingMap;
+}
+
+// ZoneSampler - modify
+void unc::ZoneSampler::setKeyMap( KeyMap* map )
+{
+	// a map not yet picked up by the audio thread is still ours
+	delete pendingMap.exchange( map != nullptr ? map : new KeyMap() );
+}
+
+// ZoneSampler - AudioIODeviceCallback
+void unc::ZoneSampler::audioDeviceIOCallback( const float**, int, float** outputChannelData, int numOutputChannels, int numSamples )
+{
+	for( int ch = 0; ch < numOutputChannels; ++ch ){
+		if( outputChannelData[ ch ] != nullptr ){
+			FloatVectorOperations::clear( outputChannelData[ ch ], numSamples );
+		}
+	}
+	switchKeyMap();
+
+	// render between midi events, so notes start sample accurate
+	// events are placed by their age, so the last block's events spread over this one in order
+	const auto now = Time::getMillisecondCounterHiRes() * 0.001;
+	int pos = 0;
+	int start1, size1, start2, size2;
+	midiFifo.prepareToRead( midiFifo.getNumReady(), start1, size1, start2, size2 );
+	auto play = [ & ]( int index ){
+		const auto& event = midiEvents[ index ];
+		const auto eventPos = jlimit( pos, numSamples, numSamples - roundToInt( ( now - event.time ) * sampleRate ) );
+		renderVoices( outputChannelData, numOutputChannels, pos, eventPos - pos );
+		handleMidi( MidiMessage( event.data, event.size ) );
+		pos = eventPos;
+	};
+	for( int i = 0; i < size1; ++i ){
+		play( start1 + i );
+	}
+	for( int i = 0; i < size2; ++i ){
+		play( start2 + i );
+	}
+	midiFifo.finishedRead( size1 + size2 );
+	renderVoices( outputChannelData, numOutputChannels, pos, numSamples - pos );
+}
+
+void unc::ZoneSampler::audioDeviceAboutToStart( AudioIODevice* device )
+{
+	// one channel per output, voices of fewer channels wrap around
+	const auto numOutputs = device->getActiveOutputChannels().countNumberOfSetBits();
+	voiceBuffer.setSize( jlimit( 1, ( int )aud::MaxNumAudioChannels, numOutputs ), jmax( 1, device->getCurrentBufferSizeSamples() ) );
+	sampleRate = device->getCurrentSampleRate();
+}
+
+void unc::ZoneSampler::audioDeviceStopped()
+{
+	for( auto& voice : voices ){
+		voice.note = -1;
+	}
+}
+
+// ZoneSampler - MidiInputCallback
+void unc::ZoneSampler::handleIncomingMidiMessage( MidiInput*, const MidiMessage& message )
+{
+	const auto size = message.getRawDataSize();
+	if( size > 3 || message.isSysEx() ){
+		return;
+	}
+	const ScopedLock lock( midiInputLock );
+	int start1, size1, start2, size2;
+	midiFifo.prepareToWrite( 1, start1, size1, start2, size2 );
+	if( size1 == 0 ){
+		return;
+	}
+	auto& event = midiEvents[ start1 ];
+	memcpy( event.data, message.getRawData(), ( size_t )size );
+	event.size = size;
+	event.time = message.getTimeStamp() > 0. ? message.getTimeStamp() : Time::getMillisecondCounterHiRes() * 0.001;
+	midiFifo.finishedWrite( 1 );
+}
+
+// ZoneSampler - process
+void unc::ZoneSampler::handleMidi( const MidiMessage& message )
+{
+	if( message.isNoteOn() ){
+		startNote( message.getNoteNumber(), message.getFloatVelocity() );
+	}
+	else if( message.isNoteOff() ){
+		releaseNote( message.getNoteNumber(), ReleaseLength );
+	}
+	else if( message.isAllNotesOff() || message.isAllSoundOff() ){
+		for( int note = 0; note < 128; ++note ){
+			releaseNote( note, StealLength );
+		}
+	}
+}
+
+void unc::ZoneSampler::startNote( int note, float velocity )
+{
+	if( currentMap == nullptr || currentMap->keys[ note ].audio == nullptr ){
+		return;
+	}
+	const auto& key = currentMap->keys[ note ];
+
+	// retrigger fades out the sounding note
+	releaseNote( note, StealLength );
+
+	// steal the oldest sounding voice if all are busy
+	Voice* oldest = nullptr;
+	int numSounding = 0;
+	for( auto& voice : voices ){
+		if( voice.isActive() && !voice.isReleasing() ){
+			++numSounding;
+			if( oldest == nullptr || voice.startedAt < oldest->startedAt ){
+				oldest = &voice;
+			}
+		}
+	}
+	if( numSounding >= NumVoices && oldest != nullptr ){
+		oldest->gainStep = -oldest->gain / StealLength;
+	}
+	// free voice, or cut the oldest fading one if even spares are busy
+	Voice* target = nullptr;
+	for( auto& voice : voices ){
+		if( !voice.isActive() ){
+			target = &voice;
+			break;
+		}
+		if( target == nullptr || voice.startedAt < target->startedAt ){
+			target = &voice;
+		}
+	}
+	target->map = currentMap;
+	target->note = note;
+	target->isLooping = key.isLooping;
+	target->gain = velocity;
+	target->gainStep = 0.f;
+	target->startedAt = numStarted++;
+	target->resampler.setSample( *key.audio );
+	target->resampler.reset( 0 );
+}
+
+void unc::ZoneSampler::releaseNote( int note, int releaseLength )
+{
+	for( auto& voice : voices ){
+		if( voice.note != note || voice.isReleasing() ){
+			continue;
+		}
+		// play zones ring out unless cut
+		if( voice.isLooping || releaseLength == StealLength ){
+			voice.gainStep = -voice.gain / releaseLength;
+		}
+	}
+}
+
+void unc::ZoneSampler::switchKeyMap()
+{
+	// old map is freed once its voices are silent
+	if( drainingMap != nullptr ){
+		bool isPlaying = false;
+		for( const auto& voice : voices ){
+			isPlaying |= voice.isActive() && voice.map == drainingMap;
+		}
+		if( !isPlaying ){
+			retire( drainingMap );
+			drainingMap = nullptr;
+		}
+	}
+	auto* next = pendingMap.exchange( nullptr );
+	if( next == nullptr ){
+		return;
+	}
+	// a second switch while draining cuts the oldest map
+	if( drainingMap != nullptr ){
+		for( auto& voice : voices ){
+			if( voice.map == drainingMap ){
+				voice.note = -1;
+			}
+		}
+		retire( drainingMap );
+	}
+	for( auto& voice : voices ){
+		if( voice.isActive() && !voice.isReleasing() ){
+			voice.gainStep = -voice.gain / StealLength;
+		}
+	}
+	drainingMap = currentMap;
+	currentMap = next;
+}
+
+void unc::ZoneSampler::renderVoices( float* const* output, int numChannels, int startSample, int numSamples )
+{
+	// in chunks of the voice buffer
+	for( int pos = 0; pos < numSamples; pos += voiceBuffer.getNumSamples() ){
+		const auto len = jmin( voiceBuffer.getNumSamples(), numSamples - pos );
+		for( auto& voice : voices ){
+			if( voice.isActive() ){
+				renderVoice( voice, output, numChannels, startSample + pos, len );
+			}
+		}
+	}
+}
+
+void unc::ZoneSampler::renderVoice( Voice& voice, float* const* output, int numChannels, int startSample, int numSamples )
+{
+	auto& resampler = voice.resampler;
+	for( int done = 0; done < numSamples && voice.isActive(); ){
+		// loops wrap, play zones end
+		auto remaining = resampler.getRangeLength() - resampler.getPlayPos();
+		if( remaining <= 0 ){
+			if( !voice.isLooping || resampler.getRangeLength() == 0 ){
+				voice.note = -1;
+				return;
+			}
+			resampler.reset( 0 );
+			remaining = resampler.getRangeLength();
+		}
+		const auto len = jmin( numSamples - done, remaining );
+		AudioBuffer<float> block( voiceBuffer.getArrayOfWritePointers(), voiceBuffer.getNumChannels(), len );
+		resampler.process( block );
+
+		// gain ramps while releasing
+		const auto gainEnd = jmax( 0.f, voice.gain + voice.gainStep * len );
+		for( int ch = 0; ch < numChannels; ++ch ){
+			if( output[ ch ] == nullptr ){
+				continue;
+			}
+			auto* write = output[ ch ] + startSample + done;
+			const auto* read = block.getReadPointer( ch % block.getNumChannels() );
+			if( voice.gainStep == 0.f ){
+				FloatVectorOperations::addWithMultiply( write, read, voice.gain, len );
+				continue;
+			}
+			for( int i = 0; i < len; ++i ){
+				write[ i ] += read[ i ] * jmax( 0.f, voice.gain + voice.gainStep * i );
+			}
+		}
+		voice.gain = gainEnd;
+		if( voice.isReleasing() && voice.gain <= 0.f ){
+			voice.note = -1;
+		}
+		done += len;
+	}
+}
+
+void unc::ZoneSampler::retire( KeyMap* map )
+{
+	int start1, size1, start2, size2;
+	retiredFifo.prepareToWrite( 1, start1, size1, start2, size2 );
+	if( size1 == 0 ){
+		// message thread stalled for long, better to leak than to free here
+		jassertfalse;
+		return;
+	}
+	retired[ start1 ] = map;
+	retiredFifo.finishedWrite( 1 );
+}
+
+// ZoneSampler - Timer
+void unc::ZoneSampler::timerCallback()
+{
+	while( retiredFifo.getNumReady() > 0 ){
+		int start1, size1, start2, size2;
+		retiredFifo.prepareToRead( 1, start1, size1, start2, size2 );
+		delete retired[ start1 ];
+		retiredFifo.finishedRead( 1 );
+	}
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include "AudioClip.h"
+#include "AudioPlayback.h"
+
+namespace unc
+{
+	/// Zones rendered and mapped to midi notes, voices only read from it.
+	struct KeyMap
+	{
+		/// Note of the first zone, the following zones map to the notes above.
+		static const int FirstNote = 60;
+
+		struct Key
+		{
+			std::unique_ptr<AudioBuffer<float>> audio;
+			bool isLooping = false;
+		};
+		std::array<Key, 128> keys;
+	};
+
+	/// \returns the zones of clip, rendered on the calling thread, nullptr clip maps nothing.
+	KeyMap* createKeyMap( AudioClip* clip );
+
+	/// Polyphonic audition of zones triggered by midi. Voices are preallocated and
+	/// stolen when all are busy, midi arrives through a lock free queue, the audio thread never allocates or locks.
+	class ZoneSampler : public AudioIODeviceCallback,
+		public MidiInputCallback,
+		private Timer
+	{
+	public:
+		static const int NumVoices = 64;
+
+		/// Voices of stolen notes, so they can fade out instead of being cut.
+		static const int NumSpareVoices = 16;
+
+		/// Release of loops after note off, and fade of stolen voices.
+		/// @{
+		static const int ReleaseLength = 2048;
+		static const int StealLength = 64;
+		/// @}
+
+		ZoneSampler();
+		~ZoneSampler();
+
+		// modify
+		/// Takes ownership of map, voices of the previous one fade out. Call from the message thread.
+		void setKeyMap( KeyMap* map );
+
+		// access
+		/// Register with the device manager to receive midi.
+		MidiInputCallback* getMidiInput(){ return this; }
+
+		// MidiInputCallback
+		/// Queues short messages for the audio thread, system exclusive and messages beyond a full queue are dropped.
+		void handleIncomingMidiMessage( MidiInput* source, const MidiMessage& message )override;
+
+		// AudioIODeviceCallback
+		void audioDeviceIOCallback( const float** inputChannelData, int numInputChannels, float** outputChannelData, int numOutputChannels, int numSamples )override;
+		void audioDeviceAboutToStart( AudioIODevice* device )override;
+		void audioDeviceStopped()override;
+
+	private:
+		struct Voice
+		{
+			Voice();
+
+			// access
+			bool isActive() const{ return note >= 0; }
+			bool isReleasing() const{ return gainStep < 0.f; }
+
+			aud::Resampler resampler;
+			const KeyMap* map = nullptr;
+			int note = -1;
+			bool isLooping = false;
+			float gain = 0.f;
+			float gainStep = 0.f;
+			uint32 startedAt = 0;
+		};
+
+		// process
+		void handleMidi( const MidiMessage& message );
+		void startNote( int note, float velocity );
+		void releaseNote( int note, int releaseLength );
+		void switchKeyMap();
+
+		/// Adds all voices to output.
+		void renderVoices( float* const* output, int numChannels, int startSample, int numSamples );
+		void renderVoice( Voice& voice, float* const* output, int numChannels, int startSample, int numSamples );
+
+		/// Hands map to the message thread.
+		void retire( KeyMap* map );
+
+		// Timer
+		void timerCallback()override;
+
+		std::array<Voice, NumVoices + NumSpareVoices> voices;
+		uint32 numStarted = 0;
+		AudioBuffer<float> voiceBuffer; // allocated before the device starts
+		double sampleRate = 44100.;
+
+		/// Short midi message as received, time in seconds of Time::getMillisecondCounterHiRes().
+		struct MidiEvent
+		{
+			uint8 data[ 3 ];
+			int size = 0;
+			double time = 0.;
+		};
+		static const int NumMidiEvents = 1024;
+		AbstractFifo midiFifo{ NumMidiEvents };
+		std::array<MidiEvent, NumMidiEvents> midiEvents;
+		CriticalSection midiInputLock; // serializes midi inputs, never taken by the audio thread
+
+		std::atomic<KeyMap*> pendingMap{ nullptr };
+		KeyMap* currentMap = nullptr; // audio thread only
+		KeyMap* drainingMap = nullptr; // audio thread only, while its voices fade out
+
+		static const int NumRetired = 32;
+		AbstractFifo retiredFifo{ NumRetired };
+		std::array<KeyMap*, NumRetired> retired{};
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( ZoneSampler );
+	};
+}
@@ -12,6 +12,12 @@ aud::AudioSettingsDisplay::AudioSettingsDisplay()
 	addAndMakeVisible( bufferDisplay );
 	addAndMakeVisible( bitsLabel );
 	addAndMakeVisible( bitsDisplay );
+	addAndMakeVisible( loadLabel );
+	addAndMakeVisible( loadDisplay );
+	addAndMakeVisible( worstLabel );
+	addAndMakeVisible( worstDisplay );
+	addAndMakeVisible( xRunLabel );
+	addAndMakeVisible( xRunDisplay );
 	addAudioSettingsListener( this );
 }
 
@@ -24,6 +30,18 @@ void aud::AudioSettingsDisplay::paint( Graphics & g )
 {
 	// bg
 	g.fillAll( greyBgMid );
+
+	// histogram, bars from fast to overloaded callbacks
+	const auto maxCount = *std::max_element( recentCounts.begin(), recentCounts.end() );
+	if( maxCount <= 0.f || histogramBounds.isEmpty() ){
+		return;
+	}
+	const auto barWidth = histogramBounds.getWidth() / ( float )CallbackMonitor::NumBins;
+	for( int i = 0; i < CallbackMonitor::NumBins; ++i ){
+		const auto barHeight = histogramBounds.getHeight() * recentCounts[ i ] / maxCount;
+		g.setColour( i == CallbackMonitor::NumBins - 1 ? Colours::red : greyFgActive );
+		g.fillRect( histogramBounds.getX() + i * barWidth, histogramBounds.getBottom() - barHeight, barWidth - dims::pad, barHeight );
+	}
 }
 
 void aud::AudioSettingsDisplay::resized()
@@ -47,6 +65,23 @@ void aud::AudioSettingsDisplay::resized()
 	b.removeFromLeft( dims::pad );
 	bitsDisplay.setBounds( b.removeFromLeft( dims::wM ) );
 	b.removeFromLeft( dims::padM );
+
+	// callback load
+	loadLabel.setBounds( b.removeFromLeft( dims::wS ) );
+	b.removeFromLeft( dims::pad );
+	loadDisplay.setBounds( b.removeFromLeft( dims::wM ) );
+	b.removeFromLeft( dims::padM );
+	worstLabel.setBounds( b.removeFromLeft( dims::wS ) );
+	b.removeFromLeft( dims::pad );
+	worstDisplay.setBounds( b.removeFromLeft( dims::wM ) );
+	b.removeFromLeft( dims::padM );
+	xRunLabel.setBounds( b.removeFromLeft( dims::wS ) );
+	b.removeFromLeft( dims::pad );
+	xRunDisplay.setBounds( b.removeFromLeft( dims::wM ) );
+	b.removeFromLeft( dims::padM );
+
+	// histogram
+	histogramBounds = b.removeFromLeft( dims::wM );
 }
 
 void aud::AudioSettingsDisplay::audioSettingsChanged( const AudioSettings& newAudioSettings )
@@ -55,3 +90,30 @@ void aud::AudioSettingsDisplay::audioSettingsChanged( const AudioSettings& newAu
 	bufferDisplay.setText( String( newAudioSettings.bufferSize ), dontSendNotification );
 	bitsDisplay.setText( String( newAudioSettings.bitsPerSample ), dontSendNotification );
 }
+
+void aud::AudioSettingsDisplay::setMonitor( CallbackMonitor* newMonitor )
+{
+	monitor = newMonitor;
+	if( monitor ){
+		startTimerHz( 4 );
+	}
+	else{
+		stopTimer();
+	}
+}
+
+// AudioSettingsDisplay - Timer
+void aud::AudioSettingsDisplay::timerCallback()
+{
+	auto stats = monitor->popStats();
+	loadDisplay.setText( String( roundToInt( stats.load * 100.f ) ) + " %", dontSendNotification );
+	worstDisplay.setText( String( stats.worstMs, 2 ) + " ms", dontSendNotification );
+	xRunDisplay.setText( String( stats.numXRuns ), dontSendNotification );
+
+	// new callbacks per bin, older ones fade out over a few seconds
+	for( int i = 0; i < CallbackMonitor::NumBins; ++i ){
+		recentCounts[ i ] = recentCounts[ i ] * 0.8f + ( float )( stats.histogram[ i ] - lastCounts[ i ] );
+		lastCounts[ i ] = stats.histogram[ i ];
+	}
+	repaint( histogramBounds );
+}
@@ -4,10 +4,13 @@
 #include "MainHeaders.h"
 #include "LookAndFeel.h"
 
+#include "AudioMonitor.h"
+
 namespace aud
 {
 	class AudioSettingsDisplay : public Component,
-		public AudioSettingsListener
+		public AudioSettingsListener,
+		private Timer
 	{
 	public:
 		AudioSettingsDisplay();
@@ -20,13 +23,32 @@ namespace aud
 		// AudioSettingsListener
 		void audioSettingsChanged( const AudioSettings& newAudioSettings )override;
 
+		// modify
+		/// Polls callback stats of monitor, which must outlive this.
+		void setMonitor( CallbackMonitor* newMonitor );
+
 	private:
+		// Timer
+		void timerCallback()override;
+
 		Label srLabel{ "srLabel", "SR" };
 		Label srDisplay{ "srDisplay" };
 		Label bufferLabel{ "bufferLabel", "Buf" };
 		Label bufferDisplay{ "bufferDisplay" };
 		Label bitsLabel{ "bitsLabel", "Bits" };
 		Label bitsDisplay{ "bitsDisplay" };
+		Label loadLabel{ "loadLabel", "Load" };
+		Label loadDisplay{ "loadDisplay" };
+		Label worstLabel{ "worstLabel", "Max" };
+		Label worstDisplay{ "worstDisplay" };
+		Label xRunLabel{ "xRunLabel", "Xrun" };
+		Label xRunDisplay{ "xRunDisplay" };
+
+		// histogram of callback times, decaying so it shows recent seconds
+		CallbackMonitor* monitor = nullptr;
+		std::array<int64, CallbackMonitor::NumBins> lastCounts{};
+		std::array<float, CallbackMonitor::NumBins> recentCounts{};
+		Rectangle<int> histogramBounds;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( AudioSettingsDisplay );
 	};
@@ -0,0 +1,137 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "AudioStorage.h"
+
+using namespace aud;
+
+// same scaling as juce's integer to float conversion, so decoded samples convert back exactly
+const static float Int16Scale( 32768.f );
+const static float Int24Scale( 8388608.f );
+const static int CompareBlockLength( 4096 );
+
+// getCompactFormat
+SampleFormat aud::getCompactFormat( int bitsPerSample )
+{
+	if( bitsPerSample > 0 && bitsPerSample <= 16 ){
+		return SampleFormat::Int16;
+	}
+	if( bitsPerSample > 0 && bitsPerSample <= 24 ){
+		return SampleFormat::Int24;
+	}
+	return SampleFormat::Float32;
+}
+
+// SampleBuffer
+aud::SampleBuffer::SampleBuffer( const AudioBuffer<float>& source, SampleFormat format_ ) :
+	numChannels( source.getNumChannels() ),
+	numSamples( source.getNumSamples() ),
+	format( format_ )
+{
+	if( !pack( source ) ){
+		format = SampleFormat::Float32;
+		pack( source );
+	}
+}
+
+bool aud::SampleBuffer::pack( const AudioBuffer<float>& source )
+{
+	data.malloc( getSizeInBytes() );
+	for( int ch = 0; ch < numChannels; ++ch ){
+		const auto* in = source.getReadPointer( ch );
+		auto* out = data + ( size_t )ch * ( size_t )numSamples * ( size_t )getBytesPerSample( format );
+		if( format == SampleFormat::Float32 ){
+			memcpy( out, in, sizeof( float ) * ( size_t )numSamples );
+			continue;
+		}
+		const auto scale = format == SampleFormat::Int16 ? Int16Scale : Int24Scale;
+		for( int i = 0; i < numSamples; ++i ){
+			const auto q = roundToInt( in[ i ] * scale );
+			if( q < -scale || q >= scale || q * ( 1.f / scale ) != in[ i ] ){
+				return false;
+			}
+			if( format == SampleFormat::Int16 ){
+				reinterpret_cast<int16*>( out )[ i ] = ( int16 )q;
+			}
+			else{
+				out[ 3 * i ] = ( uint8 )q;
+				out[ 3 * i + 1 ] = ( uint8 )( q >> 8 );
+				out[ 3 * i + 2 ] = ( uint8 )( q >> 16 );
+			}
+		}
+	}
+	return true;
+}
+
+// SampleBuffer - process
+void aud::SampleBuffer::read( int channel, int startSample, int num, float* dest ) const
+{
+	jassert( isPositiveAndBelow( channel, numChannels ) && startSample >= 0 && startSample + num <= numSamples );
+
+	// plain loops without branches, so conversions vectorize
+	const auto* in = getChannel( channel ) + ( size_t )startSample * ( size_t )getBytesPerSample( format );
+	switch( format ){
+		case SampleFormat::Int16:{
+			const auto* samples = reinterpret_cast<const int16*>( in );
+			for( int i = 0; i < num; ++i ){
+				dest[ i ] = samples[ i ] * ( 1.f / Int16Scale );
+			}
+			break;
+		}
+		case SampleFormat::Int24:
+			for( int i = 0; i < num; ++i ){
+				const auto* p = in + 3 * i;
+				const auto packed = ( int32 )( ( uint32 )p[ 0 ] << 8 | ( uint32 )p[ 1 ] << 16 | ( uint32 )p[ 2 ] << 24 );
+				dest[ i ] = ( packed >> 8 ) * ( 1.f / Int24Scale );
+			}
+			break;
+		default:
+			memcpy( dest, in, sizeof( float ) * ( size_t )num );
+			break;
+	}
+}
+
+AudioBuffer<float> aud::SampleBuffer::toFloat( int startSample, int num ) const
+{
+	startSample = jlimit( 0, numSamples, startSample );
+	num = jlimit( 0, numSamples - startSample, num );
+	AudioBuffer<float> ret( numChannels, num );
+	for( int ch = 0; ch < numChannels; ++ch ){
+		read( ch, startSample, num, ret.getWritePointer( ch ) );
+	}
+	return ret;
+}
+
+AudioBuffer<float> aud::SampleBuffer::asFloat() const
+{
+	if( format != SampleFormat::Float32 ){
+		return toFloat( 0, numSamples );
+	}
+	HeapBlock<float*> channels( numChannels );
+	for( int ch = 0; ch < numChannels; ++ch ){
+		channels[ ch ] = reinterpret_cast<float*>( const_cast<uint8*>( getChannel( ch ) ) );
+	}
+	return AudioBuffer<float>( channels, numChannels, numSamples );
+}
+
+bool aud::SampleBuffer::hasSameSamples( const SampleBuffer& other ) const
+{
+	if( numChannels != other.numChannels || numSamples != other.numSamples ){
+		return false;
+	}
+	if( format == other.format ){
+		return memcmp( data, other.data, getSizeInBytes() ) == 0;
+	}
+	// convert blocks of both, never the whole buffer
+	float first[ CompareBlockLength ];
+	float second[ CompareBlockLength ];
+	for( int ch = 0; ch < numChannels; ++ch ){
+		for( int pos = 0; pos < numSamples; pos += CompareBlockLength ){
+			const auto num = jmin( CompareBlockLength, numSamples - pos );
+			read( ch, pos, num, first );
+			other.read( ch, pos, num, second );
+			if( memcmp( first, second, sizeof( float ) * ( size_t )num ) != 0 ){
+				return false;
+			}
+		}
+	}
+	return true;
+}
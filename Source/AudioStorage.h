@@ -0,0 +1,65 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+namespace aud
+{
+	/// How samples are held in memory.
+	enum class SampleFormat
+	{
+		Float32, Int16, Int24
+	};
+
+	/// \returns the smallest format holding integer samples of bitsPerSample without loss.
+	SampleFormat getCompactFormat( int bitsPerSample );
+
+	inline int getBytesPerSample( SampleFormat format )
+	{
+		switch( format ){
+			case SampleFormat::Int16: return 2;
+			case SampleFormat::Int24: return 3;
+			default: return 4;
+		}
+	}
+
+	/// Immutable audio, stored as float or as 16 or packed 24 bit integers and converted to float as it is read.
+	class SampleBuffer
+	{
+	public:
+		/// Stores source in format, or as float if format would not hold it without loss.
+		SampleBuffer( const AudioBuffer<float>& source, SampleFormat format );
+
+		// process
+		/// Converts numSamples of channel from startSample to float, must be within bounds.
+		void read( int channel, int startSample, int numSamples, float* dest ) const;
+
+		/// \returns float copy of numSamples from startSample, shortened to the buffer end.
+		AudioBuffer<float> toFloat( int startSample, int numSamples ) const;
+
+		/// \returns all audio as float, referring to the storage if it is float already, which must not be written.
+		AudioBuffer<float> asFloat() const;
+
+		/// \returns true if other holds bitwise identical audio as float, comparing the stored bytes if both share a format.
+		bool hasSameSamples( const SampleBuffer& other ) const;
+
+		// access
+		int getNumChannels() const{ return numChannels; }
+		int getNumSamples() const{ return numSamples; }
+		SampleFormat getFormat() const{ return format; }
+		size_t getSizeInBytes() const{ return ( size_t )numChannels * ( size_t )numSamples * ( size_t )getBytesPerSample( format ); }
+
+	private:
+		/// \returns false if source does not fit format without loss.
+		bool pack( const AudioBuffer<float>& source );
+
+		const uint8* getChannel( int channel ) const{ return data + ( size_t )channel * ( size_t )numSamples * ( size_t )getBytesPerSample( format ); }
+
+		int numChannels;
+		int numSamples;
+		SampleFormat format;
+		HeapBlock<uint8> data;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( SampleBuffer );
+	};
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "AudioStorage.h"
+#include "AudioFunctions.h"
+
+namespace aud
+{
+	class AudioStorageTest : public UnitTest
+	{
+	public:
+		AudioStorageTest() : UnitTest( "AudioStorageTest" ){}
+
+		void runTest() override
+		{
+			testCompactFormats();
+			testFallback();
+			testWindow();
+			testSameSamples();
+		}
+
+		/// \returns noise quantized to bits, as decoded from an integer file.
+		AudioBuffer<float> createQuantized( int numChannels, int numSamples, int bits )
+		{
+			AudioBuffer<float> ret( numChannels, numSamples );
+			Random random( bits );
+			const auto scale = ( float )( 1 << ( bits - 1 ) );
+			for( int ch = 0; ch < numChannels; ++ch ){
+				for( int i = 0; i < numSamples; ++i ){
+					ret.setSample( ch, i, roundToInt( ( random.nextFloat() * 2.f - 1.f ) * scale ) / scale );
+				}
+			}
+			// full scale extremes
+			ret.setSample( 0, 0, -1.f );
+			ret.setSample( 0, 1, ( scale - 1.f ) / scale );
+			return ret;
+		}
+
+		void testCompactFormats()
+		{
+			beginTest( "testCompactFormats" );
+
+			expect( getCompactFormat( 16 ) == SampleFormat::Int16 );
+			expect( getCompactFormat( 24 ) == SampleFormat::Int24 );
+			expect( getCompactFormat( 32 ) == SampleFormat::Float32 );
+
+			// integer sources round trip exactly in their format
+			for( auto bits : { 16, 24 } ){
+				auto b = createQuantized( 3, 1001, bits );
+				SampleBuffer samples( b, getCompactFormat( bits ) );
+				expect( samples.getFormat() == getCompactFormat( bits ) );
+				expectEquals( ( int )samples.getSizeInBytes(), 3 * 1001 * bits / 8 );
+				expect( compareBuffer( samples.asFloat(), b ) );
+			}
+		}
+
+		void testFallback()
+		{
+			beginTest( "testFallback" );
+
+			// samples not on the integer grid or beyond full scale stay float
+			auto b = createQuantized( 2, 100, 16 );
+			b.setSample( 1, 50, 0.1f );
+			SampleBuffer fine( b, SampleFormat::Int16 );
+			expect( fine.getFormat() == SampleFormat::Float32 );
+			expect( compareBuffer( fine.asFloat(), b ) );
+			b.setSample( 1, 50, 1.f );
+			SampleBuffer loud( b, SampleFormat::Int24 );
+			expect( loud.getFormat() == SampleFormat::Float32 );
+
+			// float storage is read in place
+			expect( loud.asFloat().getReadPointer( 0 ) == loud.asFloat().getReadPointer( 0 ) );
+		}
+
+		void testWindow()
+		{
+			beginTest( "testWindow" );
+
+			auto b = createQuantized( 2, 500, 24 );
+			SampleBuffer samples( b, SampleFormat::Int24 );
+			auto window = samples.toFloat( 100, 50 );
+			expectEquals( window.getNumSamples(), 50 );
+			for( int ch = 0; ch < 2; ++ch ){
+				expect( memcmp( window.getReadPointer( ch ), b.getReadPointer( ch, 100 ), 50 * sizeof( float ) ) == 0 );
+			}
+			// shortened at the end
+			expectEquals( samples.toFloat( 480, 50 ).getNumSamples(), 20 );
+		}
+
+		void testSameSamples()
+		{
+			beginTest( "testSameSamples" );
+
+			// 16 bit audio held in every format, longer than a compare block
+			auto b = createQuantized( 2, 5000, 16 );
+			SampleBuffer int16( b, SampleFormat::Int16 );
+			SampleBuffer int24( b, SampleFormat::Int24 );
+			SampleBuffer float32( b, SampleFormat::Float32 );
+			expect( int16.hasSameSamples( SampleBuffer( b, SampleFormat::Int16 ) ) );
+			expect( int16.hasSameSamples( int24 ) );
+			expect( float32.hasSameSamples( int24 ) );
+
+			// a difference in the last block or in the length
+			b.setSample( 1, 4999, b.getSample( 1, 4999 ) == 0.f ? 0.5f : 0.f );
+			expect( !int24.hasSameSamples( SampleBuffer( b, SampleFormat::Int16 ) ) );
+			expect( !int16.hasSameSamples( SampleBuffer( AudioBuffer<float>( 2, 4999 ), SampleFormat::Int16 ) ) );
+		}
+	};
+	static AudioStorageTest audioStorageTest;
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "Benchmark.h"
+
+using namespace unc;
+
+// BenchmarkResult - access
+double unc::BenchmarkResult::getSeconds( double percentile ) const
+{
+	if( seconds.empty() ){
+		return 0.;
+	}
+	auto sorted = seconds;
+	std::sort( sorted.begin(), sorted.end() );
+	const auto index = jlimit( 0, ( int )sorted.size() - 1, roundToInt( percentile / 100. * ( sorted.size() - 1 ) ) );
+	return sorted[ index ];
+}
+
+double unc::BenchmarkResult::getSamplesPerSecond() const
+{
+	const auto median = getSeconds( 50. );
+	return median > 0. ? samplesPerRun / median : 0.;
+}
+
+// BenchmarkResult - persistence
+var unc::BenchmarkResult::toVar() const
+{
+	DynamicObject::Ptr ret( new DynamicObject() );
+	ret->setProperty( "name", name );
+	if( failed() ){
+		ret->setProperty( "error", error );
+		return var( ret.get() );
+	}
+	ret->setProperty( "runs", ( int )seconds.size() );
+	ret->setProperty( "samplesPerRun", samplesPerRun );
+	ret->setProperty( "samplesPerSecond", getSamplesPerSecond() );
+	ret->setProperty( "allocationsPerRun", allocationsPerRun );
+	ret->setProperty( "p50", getSeconds( 50. ) );
+	ret->setProperty( "p90", getSeconds( 90. ) );
+	ret->setProperty( "p99", getSeconds( 99. ) );
+	ret->setProperty( "min", getSeconds( 0. ) );
+	ret->setProperty( "max", getSeconds( 100. ) );
+	return var( ret.get() );
+}
+
+// Benchmark
+unc::Benchmark::Benchmark( const String& name_ ) :
+	name( name_ )
+{
+	getAllBenchmarks().add( this );
+}
+
+unc::Benchmark::~Benchmark()
+{
+	getAllBenchmarks().removeFirstMatchingValue( this );
+}
+
+Array<Benchmark*>& unc::Benchmark::getAllBenchmarks()
+{
+	static Array<Benchmark*> ret;
+	return ret;
+}
+
+// Benchmark - modify
+void unc::Benchmark::measure( const String& caseName, int64 samplesPerRun, const std::function<void()>& func, int numRuns )
+{
+	BenchmarkResult result;
+	result.name = name + "/" + caseName;
+	result.samplesPerRun = samplesPerRun;
+
+	// warm up caches and lazy allocations, then count one run
+	func();
+	{
+		AllocationCounter allocations;
+		func();
+		result.allocationsPerRun = allocations.getNumAllocations();
+	}
+
+	for( int run = 0; run < numRuns; ++run ){
+		const auto start = Time::getHighResolutionTicks();
+		func();
+		result.seconds.push_back( Time::highResolutionTicksToSeconds( Time::getHighResolutionTicks() - start ) );
+	}
+	results.push_back( std::move( result ) );
+}
+
+void unc::Benchmark::fail( const String& caseName, const String& error )
+{
+	const auto fullName = name + "/" + caseName;
+	auto result = std::find_if( results.begin(), results.end(), [ & ]( const BenchmarkResult& r ){ return r.name == fullName; } );
+	if( result == results.end() ){
+		results.push_back( {} );
+		result = results.end() - 1;
+		result->name = fullName;
+	}
+	result->seconds.clear();
+	result->error = error.isNotEmpty() ? error : "failed";
+}
+
+// runBenchmarks
+var unc::runBenchmarks( const String& filter, const File& fixtures )
+{
+	Array<var> cases;
+	int numFailed = 0;
+	for( auto* benchmark : Benchmark::getAllBenchmarks() ){
+		if( filter.isNotEmpty() && !benchmark->getName().containsIgnoreCase( filter ) ){
+			continue;
+		}
+		benchmark->fixtures = fixtures;
+		benchmark->run();
+		for( const auto& result : benchmark->getResults() ){
+			cases.add( result.toVar() );
+			numFailed += result.failed() ? 1 : 0;
+		}
+	}
+	DynamicObject::Ptr ret( new DynamicObject() );
+	ret->setProperty( "version", ProjectInfo::versionString );
+	ret->setProperty( "cpu", SystemStats::getCpuVendor() );
+	ret->setProperty( "cpuMhz", SystemStats::getCpuSpeedInMegaherz() );
+	ret->setProperty( "numCpus", SystemStats::getNumCpus() );
+	ret->setProperty( "numFailed", numFailed );
+	ret->setProperty( "cases", cases );
+	return var( ret.get() );
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include "Trace.h"
+
+namespace unc
+{
+	/// Timings of one benchmark case, one entry per run.
+	struct BenchmarkResult
+	{
+		String name;
+		int64 samplesPerRun = 0;
+		int64 allocationsPerRun = 0;
+		std::vector<double> seconds;
+
+		/// Why a run failed, its timings are meaningless then and are dropped.
+		String error;
+
+		// access
+		bool failed() const{ return error.isNotEmpty(); }
+		/// \param percentile between 0 and 100.
+		double getSeconds( double percentile ) const;
+		double getSamplesPerSecond() const;
+
+		// persistence
+		var toVar() const;
+	};
+
+	/// Base of all benchmarks, instances register themselves like UnitTest does.
+	class Benchmark
+	{
+	public:
+		explicit Benchmark( const String& name );
+		virtual ~Benchmark();
+
+		/// Calls measure() for every case.
+		virtual void run() = 0;
+
+		// modify
+		/// Runs func after a warm up for numRuns, samplesPerRun is the audio processed by one call.
+		void measure( const String& caseName, int64 samplesPerRun, const std::function<void()>& func, int numRuns = 20 );
+
+		/// Reports caseName as failed with error instead of its timings.
+		void fail( const String& caseName, const String& error );
+
+		// access
+		const String& getName() const{ return name; }
+		const std::vector<BenchmarkResult>& getResults() const{ return results; }
+
+		static Array<Benchmark*>& getAllBenchmarks();
+
+		/// Real audio files to run on, set before run().
+		File fixtures;
+
+	private:
+		String name;
+		std::vector<BenchmarkResult> results;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( Benchmark );
+	};
+
+	/// Runs all benchmarks with names containing filter, on real files found in fixtures.
+	/// \returns report of all cases, as JSON object.
+	var runBenchmarks( const String& filter, const File& fixtures );
+}
@@ -12,13 +12,18 @@ namespace unc
 		openProject,
 		saveProject,
 		saveProjectAs,
+		exportRenderTrace,
 
 		// Edit
 		writeAllZones,
 		writeZoneToSelected,
 		removeZoneFromSelected,
 		sortClipsByName,
-		sortClipsByLength
+		sortClipsByLength,
+		trimZoneStarts,
+		trimZoneEnds,
+		detectPitch,
+		addTransitionZones
 	};
 
 	namespace CommandCategories
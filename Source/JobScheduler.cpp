@@ -0,0 +1,281 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "JobScheduler.h"
+
+using namespace unc;
+
+// workers run below the message thread, so the ui stays smooth while all cores are busy
+const static int WorkerPriority( 3 );
+
+/// Worker of the calling thread, so jobs added from jobs stay on their worker.
+struct CurrentWorker
+{
+	const JobScheduler* scheduler = nullptr;
+	int index = -1;
+
+	/// Class of the job running on the worker, whose slot it holds, -1 if none.
+	int priority = -1;
+};
+thread_local CurrentWorker currentWorker;
+
+// JobScheduler
+unc::JobScheduler::JobScheduler( int numWorkers )
+{
+	if( numWorkers <= 0 ){
+		numWorkers = jmax( 1, SystemStats::getNumCpus() - 1 );
+	}
+	for( int p = 0; p < ( int )JobPriority::NumPriorities; ++p ){
+		numRunning[ p ] = 0;
+		maxRunning[ p ] = numWorkers;
+	}
+	for( int i = 0; i < numWorkers; ++i ){
+		workers.add( new Worker( *this, i ) );
+	}
+	for( auto* worker : workers ){
+		worker->startThread( WorkerPriority );
+	}
+}
+
+unc::JobScheduler::~JobScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock( sleepLock );
+		isShuttingDown = true;
+	}
+	for( auto* worker : workers ){
+		worker->signalThreadShouldExit();
+	}
+	wakeUp.notify_all();
+	for( auto* worker : workers ){
+		worker->stopThread( -1 );
+	}
+}
+
+// JobScheduler - process
+JobScheduler::JobPtr unc::JobScheduler::add( std::function<void()> func, JobPriority priority, const CancelToken& token, const std::vector<JobPtr>& after )
+{
+	auto job = std::make_shared<Job>();
+	job->func = std::move( func );
+	job->priority = priority;
+	job->token = token;
+	{
+		std::lock_guard<std::mutex> lock( dependencyLock );
+		for( const auto& other : after ){
+			if( other != nullptr && !other->isFinished ){
+				other->dependents.push_back( job );
+				++job->numBlocking;
+			}
+		}
+	}
+	if( --job->numBlocking == 0 ){
+		enqueue( job );
+	}
+	return job;
+}
+
+void unc::JobScheduler::wait( const JobPtr& job )
+{
+	const auto workerIndex = getWorkerIndex();
+
+	// a waiting job gives up the slot of its class meanwhile, so the jobs it waits for run under any cap
+	const auto held = workerIndex >= 0 ? currentWorker.priority : -1;
+	if( held >= 0 ){
+		--numRunning[ held ];
+		notifyAll();
+	}
+	waitUntil( workerIndex, [ & ](){ return job->isFinished.load(); } );
+	if( held >= 0 ){
+		waitUntil( workerIndex, [ & ](){ return claimSlot( held ); } );
+	}
+}
+
+void unc::JobScheduler::waitUntil( int workerIndex, const std::function<bool()>& isDone )
+{
+	for( ;; ){
+		uint64 seen;
+		{
+			std::lock_guard<std::mutex> lock( sleepLock );
+			seen = generation;
+		}
+		if( isDone() ){
+			return;
+		}
+		// a waiting worker keeps working, so jobs waiting on jobs can not run out of workers
+		if( workerIndex >= 0 ){
+			if( auto other = findJob( workerIndex ) ){
+				runJob( other );
+				continue;
+			}
+		}
+		std::unique_lock<std::mutex> lock( sleepLock );
+		wakeUp.wait( lock, [ & ](){ return generation != seen || isShuttingDown; } );
+		if( isShuttingDown ){
+			return;
+		}
+	}
+}
+
+bool unc::JobScheduler::claimSlot( int priority )
+{
+	auto running = numRunning[ priority ].load();
+	do{
+		if( running >= maxRunning[ priority ] ){
+			return false;
+		}
+	} while( !numRunning[ priority ].compare_exchange_weak( running, running + 1 ) );
+	return true;
+}
+
+JobScheduler::JobPtr unc::JobScheduler::findJob( int workerIndex )
+{
+	for( int p = 0; p < ( int )JobPriority::NumPriorities; ++p ){
+		// claim a slot of the class before taking one of its jobs
+		if( !claimSlot( p ) ){
+			continue;
+		}
+		if( auto job = takeJob( workerIndex, p ) ){
+			return job;
+		}
+		--numRunning[ p ];
+	}
+	return nullptr;
+}
+
+JobScheduler::JobPtr unc::JobScheduler::takeJob( int workerIndex, int priority )
+{
+	// own newest job first, it is most likely still in cache
+	if( workerIndex >= 0 ){
+		auto& own = *workers[ workerIndex ];
+		std::lock_guard<std::mutex> lock( own.lock );
+		auto& queue = own.queues[ priority ];
+		if( !queue.empty() ){
+			auto ret = std::move( queue.back() );
+			queue.pop_back();
+			return ret;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock( sharedLock );
+		auto& queue = sharedQueues[ priority ];
+		if( !queue.empty() ){
+			auto ret = std::move( queue.front() );
+			queue.pop_front();
+			return ret;
+		}
+	}
+	// steal the oldest job of the others
+	for( int i = 1; i <= workers.size(); ++i ){
+		auto& other = *workers[ ( jmax( 0, workerIndex ) + i ) % workers.size() ];
+		std::lock_guard<std::mutex> lock( other.lock );
+		auto& queue = other.queues[ priority ];
+		if( !queue.empty() ){
+			auto ret = std::move( queue.front() );
+			queue.pop_front();
+			return ret;
+		}
+	}
+	return nullptr;
+}
+
+void unc::JobScheduler::runJob( const JobPtr& job )
+{
+	const auto outer = currentWorker.priority;
+	currentWorker.priority = ( int )job->priority;
+	if( !job->token.isCancelled() ){
+		job->func();
+	}
+	currentWorker.priority = outer;
+	job->func = nullptr;
+	--numRunning[ ( int )job->priority ];
+	finish( job );
+}
+
+void unc::JobScheduler::enqueue( const JobPtr& job )
+{
+	const auto workerIndex = getWorkerIndex();
+	if( workerIndex >= 0 ){
+		auto& own = *workers[ workerIndex ];
+		std::lock_guard<std::mutex> lock( own.lock );
+		own.queues[ ( int )job->priority ].push_back( job );
+	}
+	else{
+		std::lock_guard<std::mutex> lock( sharedLock );
+		sharedQueues[ ( int )job->priority ].push_back( job );
+	}
+	notifyAll();
+}
+
+void unc::JobScheduler::finish( const JobPtr& job )
+{
+	std::vector<JobPtr> ready;
+	{
+		std::lock_guard<std::mutex> lock( dependencyLock );
+		job->isFinished = true;
+		ready.swap( job->dependents );
+	}
+	for( auto& dependent : ready ){
+		if( --dependent->numBlocking == 0 ){
+			enqueue( dependent );
+		}
+	}
+	// also wakes workers skipping a class at its limit
+	notifyAll();
+}
+
+void unc::JobScheduler::notifyAll()
+{
+	{
+		std::lock_guard<std::mutex> lock( sleepLock );
+		++generation;
+	}
+	wakeUp.notify_all();
+}
+
+// JobScheduler - modify
+void unc::JobScheduler::setMaxConcurrency( JobPriority priority, int maxJobs )
+{
+	maxRunning[ ( int )priority ] = jmax( 1, maxJobs );
+	notifyAll();
+}
+
+// JobScheduler - access
+int unc::JobScheduler::getWorkerIndex() const
+{
+	return currentWorker.scheduler == this ? currentWorker.index : -1;
+}
+
+// runInBackground
+JobScheduler::JobPtr unc::runInBackground( std::function<void()> func, std::function<void()> done, JobPriority priority, const CancelToken& token, const std::vector<JobScheduler::JobPtr>& after )
+{
+	auto* scheduler = getJobScheduler();
+	auto job = scheduler->add( std::move( func ), priority, token, after );
+
+	// never cancelled, so done also runs for skipped work
+	scheduler->add( [ done ](){ MessageManager::callAsync( done ); }, JobPriority::Interactive, CancelToken(), { job } );
+	return job;
+}
+
+// JobScheduler::Worker
+unc::JobScheduler::Worker::Worker( JobScheduler& owner, int index_ ) :
+	Thread( "Job Worker " + String( index_ ) ),
+	scheduler( owner ),
+	index( index_ )
+{}
+
+void unc::JobScheduler::Worker::run()
+{
+	currentWorker = { &scheduler, index, -1 };
+	while( !threadShouldExit() ){
+		uint64 seen;
+		{
+			std::lock_guard<std::mutex> lock( scheduler.sleepLock );
+			seen = scheduler.generation;
+		}
+		if( auto job = scheduler.findJob( index ) ){
+			scheduler.runJob( job );
+			continue;
+		}
+		std::unique_lock<std::mutex> lock( scheduler.sleepLock );
+		scheduler.wakeUp.wait( lock, [ & ](){ return scheduler.generation != seen || scheduler.isShuttingDown; } );
+	}
+	currentWorker = {};
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace unc
+{
+	/// Scheduling classes, free workers pick jobs of earlier classes first.
+	enum class JobPriority
+	{
+		Interactive, Background, Batch, NumPriorities
+	};
+
+	/// Skips all jobs sharing it that have not started yet, running jobs may poll it to stop early.
+	class CancelToken
+	{
+	public:
+		// modify
+		void cancel(){ *cancelled = true; }
+
+		// access
+		bool isCancelled() const{ return *cancelled; }
+
+	private:
+		std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>( false );
+	};
+
+	/// Work stealing thread pool shared by the whole application, so features never oversubscribe the cores.
+	/// Jobs added by a job go to its worker's own queue, all others to a shared one, idle workers steal the oldest jobs of busy ones.
+	class JobScheduler
+	{
+	public:
+		/// \param numWorkers 0 uses all cores but one, which is left to the message thread.
+		JobScheduler( int numWorkers = 0 );
+
+		/// Skips all queued jobs and waits for the running ones.
+		~JobScheduler();
+
+		struct Job
+		{
+			std::function<void()> func;
+			JobPriority priority;
+			CancelToken token;
+
+			/// Unfinished jobs this one runs after, plus one while it is added.
+			std::atomic<int> numBlocking{ 1 };
+			std::vector<std::shared_ptr<Job>> dependents;
+			std::atomic<bool> isFinished{ false };
+		};
+		using JobPtr = std::shared_ptr<Job>;
+
+		// process
+		/// Queues func to run once all jobs in after are finished, skipped jobs count as finished.
+		/// \returns the job, to chain others after it or wait for it.
+		JobPtr add( std::function<void()> func, JobPriority priority, const CancelToken& token = CancelToken(), const std::vector<JobPtr>& after = {} );
+
+		/// Blocks until job is finished, workers run other jobs meanwhile.
+		/// A job waiting frees the slot of its class until job is finished, and takes one again before it continues.
+		void wait( const JobPtr& job );
+
+		// modify
+		/// Limits how many workers run jobs of priority at once, the others stay free for other classes.
+		void setMaxConcurrency( JobPriority priority, int maxJobs );
+
+		// access
+		int getNumWorkers() const{ return workers.size(); }
+		int getMaxConcurrency( JobPriority priority ) const{ return maxRunning[ ( int )priority ]; }
+
+	private:
+		class Worker : public Thread
+		{
+		public:
+			Worker( JobScheduler& owner, int index );
+
+			void run() override;
+
+			JobScheduler& scheduler;
+			int index;
+
+			/// Newest jobs at the back, taken from there by the worker and stolen from the front.
+			std::deque<JobPtr> queues[ ( int )JobPriority::NumPriorities ];
+			std::mutex lock;
+		};
+
+		// process
+		/// \returns next job the calling thread may run, nullptr if there is none or all classes with jobs are at their limit.
+		JobPtr findJob( int workerIndex );
+
+		/// Runs other jobs on workers, or sleeps, until isDone returns true or the scheduler shuts down.
+		void waitUntil( int workerIndex, const std::function<bool()>& isDone );
+
+		/// Takes a slot of the class if it is below its limit.
+		/// \returns true if taken.
+		bool claimSlot( int priority );
+		JobPtr takeJob( int workerIndex, int priority );
+		void runJob( const JobPtr& job );
+		void enqueue( const JobPtr& job );
+		void finish( const JobPtr& job );
+
+		/// Wakes idle workers and waiting threads.
+		void notifyAll();
+
+		/// \returns index of the calling thread among the workers, -1 for other threads.
+		int getWorkerIndex() const;
+
+		OwnedArray<Worker> workers;
+		std::deque<JobPtr> sharedQueues[ ( int )JobPriority::NumPriorities ];
+		std::mutex sharedLock;
+
+		std::atomic<int> numRunning[ ( int )JobPriority::NumPriorities ];
+		std::atomic<int> maxRunning[ ( int )JobPriority::NumPriorities ];
+
+		/// Guards dependents and finishing jobs.
+		std::mutex dependencyLock;
+
+		/// Changes on every new or finished job, so sleepers never miss one.
+		std::mutex sleepLock;
+		std::condition_variable wakeUp;
+		uint64 generation = 0;
+		bool isShuttingDown = false;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( JobScheduler );
+	};
+
+	/// \returns the application wide scheduler.
+	JobScheduler* getJobScheduler();
+
+	/// Queues func on the application scheduler like JobScheduler::add(), then calls done on the message thread once func finished or was skipped.
+	/// For work started by the ui, so the message thread never waits for it.
+	/// \returns the job of func, to chain others after it.
+	JobScheduler::JobPtr runInBackground( std::function<void()> func, std::function<void()> done, JobPriority priority, const CancelToken& token = CancelToken(), const std::vector<JobScheduler::JobPtr>& after = {} );
+}
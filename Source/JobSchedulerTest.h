@@ -0,0 +1,140 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "JobScheduler.h"
+#include "AudioAnalysis.h"
+
+namespace unc
+{
+	class JobSchedulerTest : public UnitTest
+	{
+	public:
+		JobSchedulerTest() : UnitTest( "JobSchedulerTest" ){}
+
+		void runTest() override
+		{
+			testPriorities();
+			testDependencies();
+			testConcurrency();
+			testNestedWait();
+			testParallelFor();
+		}
+
+		void testPriorities()
+		{
+			beginTest( "testPriorities" );
+
+			// queue behind a busy single worker, the interactive job overtakes
+			JobScheduler scheduler( 1 );
+			WaitableEvent started, release;
+			scheduler.add( [ & ](){ started.signal(); release.wait(); }, JobPriority::Batch );
+			started.wait();
+			Array<int> order;
+			CriticalSection orderLock;
+			auto batch = scheduler.add( [ & ](){ const ScopedLock lock( orderLock ); order.add( 2 ); }, JobPriority::Batch );
+			auto background = scheduler.add( [ & ](){ const ScopedLock lock( orderLock ); order.add( 1 ); }, JobPriority::Background );
+			auto interactive = scheduler.add( [ & ](){ const ScopedLock lock( orderLock ); order.add( 0 ); }, JobPriority::Interactive );
+			release.signal();
+			scheduler.wait( batch );
+			scheduler.wait( background );
+			scheduler.wait( interactive );
+			expect( order == Array<int>( 0, 1, 2 ) );
+		}
+
+		void testDependencies()
+		{
+			beginTest( "testDependencies" );
+
+			JobScheduler scheduler( 4 );
+			std::atomic<int> value{ 0 };
+			auto first = scheduler.add( [ & ](){ Thread::sleep( 10 ); value = 1; }, JobPriority::Background );
+			auto second = scheduler.add( [ & ](){ value = value * 10; }, JobPriority::Interactive, CancelToken(), { first } );
+
+			// cancelled jobs are skipped, but release their dependents
+			CancelToken token;
+			token.cancel();
+			auto skipped = scheduler.add( [ & ](){ value = -1; }, JobPriority::Background, token, { second } );
+			auto last = scheduler.add( [ & ](){ value = value + 1; }, JobPriority::Background, CancelToken(), { skipped } );
+			scheduler.wait( last );
+			expectEquals( value.load(), 11 );
+		}
+
+		void testConcurrency()
+		{
+			beginTest( "testConcurrency" );
+
+			// capped jobs waiting on their own nested jobs neither exceed the cap while working nor stall
+			JobScheduler scheduler( 4 );
+			scheduler.setMaxConcurrency( JobPriority::Batch, 2 );
+			std::atomic<int> running{ 0 };
+			std::atomic<int> peak{ 0 };
+			std::atomic<int> numDone{ 0 };
+			std::vector<JobScheduler::JobPtr> jobs;
+			for( int i = 0; i < 50; ++i ){
+				jobs.push_back( scheduler.add( [ & ](){
+					const auto now = ++running;
+					for( auto p = peak.load(); now > p && !peak.compare_exchange_weak( p, now ); ){}
+					std::vector<JobScheduler::JobPtr> nested;
+					for( int n = 0; n < 4; ++n ){
+						nested.push_back( scheduler.add( [ & ](){ ++numDone; }, JobPriority::Background ) );
+					}
+					// waiting jobs free their slot
+					--running;
+					for( auto& job : nested ){
+						scheduler.wait( job );
+					}
+					const auto resumed = ++running;
+					for( auto p = peak.load(); resumed > p && !peak.compare_exchange_weak( p, resumed ); ){}
+					--running;
+					++numDone;
+				}, JobPriority::Batch ) );
+			}
+			for( auto& job : jobs ){
+				scheduler.wait( job );
+			}
+			expectEquals( numDone.load(), 250 );
+			expect( peak <= 2 );
+		}
+
+		void testNestedWait()
+		{
+			beginTest( "testNestedWait" );
+
+			// jobs waiting on jobs of their own class, at a cap of one, two levels deep
+			JobScheduler scheduler( 4 );
+			scheduler.setMaxConcurrency( JobPriority::Batch, 1 );
+			std::atomic<int> numDone{ 0 };
+			std::vector<JobScheduler::JobPtr> jobs;
+			for( int i = 0; i < 8; ++i ){
+				jobs.push_back( scheduler.add( [ & ](){
+					auto inner = scheduler.add( [ & ](){
+						auto innermost = scheduler.add( [ & ](){ ++numDone; }, JobPriority::Batch );
+						scheduler.wait( innermost );
+						++numDone;
+					}, JobPriority::Batch );
+					scheduler.wait( inner );
+					++numDone;
+				}, JobPriority::Batch ) );
+			}
+			for( auto& job : jobs ){
+				scheduler.wait( job );
+			}
+			expectEquals( numDone.load(), 24 );
+			expectEquals( scheduler.getMaxConcurrency( JobPriority::Batch ), 1 );
+		}
+
+		void testParallelFor()
+		{
+			beginTest( "testParallelFor" );
+
+			std::vector<int> items( 1000, 0 );
+			aud::parallelFor( ( int )items.size(), [ & ]( int i ){
+				items[ ( size_t )i ] += i;
+			} );
+			for( int i = 0; i < ( int )items.size(); ++i ){
+				expectEquals( items[ ( size_t )i ], i );
+			}
+		}
+	};
+	static JobSchedulerTest jobSchedulerTest;
+}
@@ -1,8 +1,12 @@
 // Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
 #include "MainHeaders.h"
+#include <iostream>
 
+#include "AudioRenderShards.h"
+#include "JobScheduler.h"
 #include "LookAndFeel.h"
 #include "MainWindow.h"
+#include "Benchmarks.h"
 #include "Tests.h"
 
 using namespace unc;
@@ -20,10 +24,28 @@ public:
 
     void initialise( const String& commandLine )override
     {
-		// run tests
-		UnitTestRunner runner;
-		runner.runAllTests();
-
+		// headless runs quit without touching devices or settings
+		auto args = StringArray::fromTokens( commandLine, true );
+		if( args.contains( "--test" ) || args.contains( "--list-tests" ) ){
+			runTests( args );
+			return;
+		}
+		if( args.contains( "--benchmark" ) ){
+			runBenchmarks( args );
+			return;
+		}
+		if( args.contains( "--render-shard" ) || args.contains( "--measure-shard" ) ){
+			runRenderShard( args );
+			return;
+		}
+		if( args.contains( "--render-sharded" ) ){
+			runRenderSharded( args );
+			return;
+		}
+		if( args.contains( "--verify-render" ) ){
+			runVerifyRender( args );
+			return;
+		}
 		// appProperties
 		PropertiesFile::Options options;
 		options.applicationName = getApplicationName();
@@ -68,6 +90,9 @@ public:
 
     void shutdown() override
     {
+		if( isHeadless ){
+			return;
+		}
 		// recentFilesList
 		appProperties.getUserSettings()->setValue( recentFilesId, recentFilesList.toString() );
 
@@ -97,6 +122,175 @@ public:
     void anotherInstanceStarted (const String& commandLine) override
     {}
 
+	/// \returns value following option on the command line, empty if missing.
+	String getArgument( const StringArray& args, const String& option ) const
+	{
+		auto index = args.indexOf( option );
+		if( index < 0 || index + 1 >= args.size() || args[ index + 1 ].startsWith( "--" ) ){
+			return String();
+		}
+		return args[ index + 1 ].unquoted();
+	}
+
+	/// --test [filter] runs tests with names containing filter, --list-tests prints all names for sharding.
+	/// Exit code is the number of failures.
+	void runTests( const StringArray& args )
+	{
+		isHeadless = true;
+#if UNC_ENABLE_TESTS
+		audioFormatManager.registerBasicFormats();
+		auto filter = getArgument( args, "--test" );
+		Array<UnitTest*> tests;
+		for( auto* test : UnitTest::getAllTests() ){
+			if( args.contains( "--list-tests" ) ){
+				std::cout << test->getName() << std::endl;
+			}
+			else if( filter.isEmpty() || test->getName().containsIgnoreCase( filter ) ){
+				tests.add( test );
+			}
+		}
+		UnitTestRunner runner;
+		runner.runTests( tests );
+		int numFailures = 0;
+		for( int i = 0; i < runner.getNumResults(); ++i ){
+			numFailures += runner.getResult( i )->failures;
+		}
+		setApplicationReturnValue( numFailures );
+#else
+		ignoreUnused( args );
+		std::cerr << "Tests are not compiled into this build, see UNC_ENABLE_TESTS." << std::endl;
+		setApplicationReturnValue( 1 );
+#endif
+		quit();
+	}
+
+	/// --benchmark [filter] [--fixtures folder] [--report file.json] [--trace file.json], report goes to stdout without file.
+	/// Exit code is 1 if any case failed.
+	void runBenchmarks( const StringArray& args )
+	{
+		isHeadless = true;
+		audioFormatManager.registerBasicFormats();
+		auto fixtures = getArgument( args, "--fixtures" );
+		auto report = unc::runBenchmarks( getArgument( args, "--benchmark" ), fixtures.isEmpty() ? File() : File::getCurrentWorkingDirectory().getChildFile( fixtures ) );
+		auto json = JSON::toString( report );
+		if( ( int )report.getProperty( "numFailed", 0 ) > 0 ){
+			setApplicationReturnValue( 1 );
+		}
+		auto reportPath = getArgument( args, "--report" );
+		if( reportPath.isEmpty() ){
+			std::cout << json << std::endl;
+		}
+		else if( !File::getCurrentWorkingDirectory().getChildFile( reportPath ).replaceWithText( json ) ){
+			setApplicationReturnValue( 1 );
+		}
+		auto tracePath = getArgument( args, "--trace" );
+		if( tracePath.isNotEmpty() && !exportTrace( File::getCurrentWorkingDirectory().getChildFile( tracePath ) ) ){
+			setApplicationReturnValue( 1 );
+		}
+		quit();
+	}
+
+	/// --render-shard k/n --spec file --manifest file [--jobs m] renders shard k of n of a sharded render on at most m cores,
+	/// --measure-shard k/n only measures its batch gain. Exit code is 0 if the shard succeeded.
+	void runRenderShard( const StringArray& args )
+	{
+		isHeadless = true;
+		audioFormatManager.registerBasicFormats();
+		const auto isMeasuring = args.contains( "--measure-shard" );
+		const auto shard = getArgument( args, isMeasuring ? "--measure-shard" : "--render-shard" );
+		const auto numJobs = getArgument( args, "--jobs" ).getIntValue();
+		if( numJobs > 0 ){
+			jobScheduler.setMaxConcurrency( JobPriority::Batch, numJobs );
+		}
+		auto res = unc::runShard( File::getCurrentWorkingDirectory().getChildFile( getArgument( args, "--spec" ) ),
+			shard.upToFirstOccurrenceOf( "/", false, false ).getIntValue(), shard.fromFirstOccurrenceOf( "/", false, false ).getIntValue(),
+			isMeasuring, File::getCurrentWorkingDirectory().getChildFile( getArgument( args, "--manifest" ) ) );
+		if( res.failed() ){
+			std::cerr << res.getErrorMessage() << std::endl;
+		}
+		setApplicationReturnValue( res.wasOk() ? 0 : 1 );
+		quit();
+	}
+
+	/// --render-sharded project.xml --out folder [--shards n] [--no-launch] [--timeout seconds] [render options] renders all zones of the project in n worker processes,
+	/// see parseRenderSettings() for the options. With --no-launch workers are started elsewhere with the logged arguments. Exit code is 0 if all shards succeeded.
+	void runRenderSharded( const StringArray& args )
+	{
+		isHeadless = true;
+		audioFormatManager.registerBasicFormats();
+		const auto project = File::getCurrentWorkingDirectory().getChildFile( getArgument( args, "--render-sharded" ) );
+		const auto out = getArgument( args, "--out" );
+		std::unique_ptr<XmlElement> xml( XmlDocument::parse( project ) );
+		auto* clipsXml = xml != nullptr ? xml->getChildByName( "AudioClips" ) : nullptr;
+		if( clipsXml == nullptr || out.isEmpty() ){
+			std::cerr << "Error reading project " << project.getFullPathName() << " or missing --out" << std::endl;
+			setApplicationReturnValue( 1 );
+			quit();
+			return;
+		}
+		const auto outDir = File::getCurrentWorkingDirectory().getChildFile( out );
+
+		// clip files are relative to the project
+		project.getParentDirectory().setAsCurrentWorkingDirectory();
+		AudioClips clips;
+		RenderSettings settings;
+		auto res = parseRenderSettings( args, settings );
+		if( res.wasOk() ){
+			res = clips.fromXml( clipsXml );
+		}
+		if( res.wasOk() ){
+			ShardSettings shards;
+			const auto numShards = getArgument( args, "--shards" ).getIntValue();
+			if( numShards > 0 ){
+				shards.numShards = numShards;
+			}
+			shards.launchWorkers = !args.contains( "--no-launch" );
+			shards.timeoutSeconds = jmax( 0, getArgument( args, "--timeout" ).getIntValue() );
+			res = renderSharded( clips, outDir, settings, shards );
+		}
+		if( res.failed() ){
+			std::cerr << res.getErrorMessage() << std::endl;
+		}
+		setApplicationReturnValue( res.wasOk() ? 0 : 1 );
+		quit();
+	}
+
+	/// --verify-render project.xml [render options] renders all zones of the project twice with different parallelism and prints their hashes to stdout,
+	/// see parseRenderSettings() for the options.
+	/// Exit code is 0 if both renders are bit identical.
+	void runVerifyRender( const StringArray& args )
+	{
+		isHeadless = true;
+		audioFormatManager.registerBasicFormats();
+		const auto project = File::getCurrentWorkingDirectory().getChildFile( getArgument( args, "--verify-render" ) );
+		std::unique_ptr<XmlElement> xml( XmlDocument::parse( project ) );
+		auto* clipsXml = xml != nullptr ? xml->getChildByName( "AudioClips" ) : nullptr;
+		if( clipsXml == nullptr ){
+			std::cerr << "Error reading project " << project.getFullPathName() << std::endl;
+			setApplicationReturnValue( 1 );
+			quit();
+			return;
+		}
+		// clip files are relative to the project
+		project.getParentDirectory().setAsCurrentWorkingDirectory();
+		AudioClips clips;
+		RenderSettings settings;
+		auto res = parseRenderSettings( args, settings );
+		if( res.wasOk() ){
+			res = clips.fromXml( clipsXml );
+		}
+		StringArray hashes;
+		if( res.wasOk() ){
+			res = verifyDeterminism( createRenderJobs( clips, project.getParentDirectory() ), settings, hashes );
+		}
+		std::cout << hashes.joinIntoString( "\n" ) << std::endl;
+		if( res.failed() ){
+			std::cerr << res.getErrorMessage() << std::endl;
+		}
+		setApplicationReturnValue( res.wasOk() ? 0 : 1 );
+		quit();
+	}
+
 	// ChangeListener
 	void changeListenerCallback( ChangeBroadcaster* source )override
 	{
@@ -110,6 +304,7 @@ public:
 	
 	lnf::Look look;
     std::unique_ptr<MainWindow> mainWindow;
+	bool isHeadless = false;
 	
 	// app
 	UndoManager undoManager;
@@ -126,6 +321,9 @@ public:
 	AudioThumbnailCache audioThumbnailCache{ ( 512 ) };
 	AudioSettings audioSettings{ 44100., 1024, 24 };
 	ListenerList<AudioSettingsListener> audioSettingsListeners;
+
+	// jobs, stopped before everything they may use
+	JobScheduler jobScheduler;
 };
 
 // app
@@ -195,5 +393,11 @@ void removeAudioSettingsListener( AudioSettingsListener* listener )
 	getApp()->audioSettingsListeners.remove( listener );
 }
 
+// jobs
+JobScheduler* unc::getJobScheduler()
+{
+	return &getApp()->jobScheduler;
+}
+
 // This macro generates the main() routine that launches the app.
 START_JUCE_APPLICATION( UnicycleApplication )
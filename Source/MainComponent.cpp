@@ -26,15 +26,21 @@ unc::MainComponent::MainComponent( MenuBarModel* menuBarModel )
     setSize( 800, 600 );
 
 	// audio
-	getAudioDeviceManager()->addAudioCallback( &soundPlayer );
+	getAudioDeviceManager()->addAudioCallback( &soundMonitor );
+	getAudioDeviceManager()->addMidiInputCallback( String(), zoneSampler.getMidiInput() );
+	audioSettingsDisplay.setMonitor( &soundMonitor );
+
+	// zones follow edits
+	getUndoManager()->addChangeListener( this );
 }
 
 unc::MainComponent::~MainComponent()
 {
-	stopPlaying();
+	getUndoManager()->removeChangeListener( this );
 
 	// audio
-	getAudioDeviceManager()->removeAudioCallback( &soundPlayer );
+	getAudioDeviceManager()->removeMidiInputCallback( String(), zoneSampler.getMidiInput() );
+	getAudioDeviceManager()->removeAudioCallback( &soundMonitor );
 }
 
 // MainComponent - Component
@@ -61,8 +67,7 @@ void unc::MainComponent::resized()
 	b.removeFromTop( dims::padM );
 
 	// audioSettingsDisplay
-	audioSettingsDisplay.setBounds( foot.removeFromLeft( dims::wXXL ));
-	foot.removeFromLeft( dims::padM );
+	audioSettingsDisplay.setBounds( foot );
 
 	// audioClipEditor
 	audioClipEditor.setBounds( b );
@@ -71,17 +76,12 @@ void unc::MainComponent::resized()
 // MainComponent - MainInterface
 void unc::MainComponent::playAudioBuffer( AudioBuffer<float>* buffer, bool shouldLoop )
 {
-	stopPlaying();
-	playedBuffer.reset( buffer );
-	playedSource.reset( new MemoryAudioSource( *playedBuffer, false, shouldLoop ) );
-	soundPlayer.setSource( playedSource.get() );
+	previewPlayer.play( buffer, shouldLoop );
 }
 
 void unc::MainComponent::stopPlaying()
 {
-	soundPlayer.setSource( nullptr );
-	playedSource.reset();
-	playedBuffer.reset();
+	previewPlayer.stop();
 }
 
 // MainComponent - ApplicationCommandTarget
@@ -98,6 +98,10 @@ void unc::MainComponent::getAllCommands( Array<CommandID>& commands )
 	commands.add( CommandIDs::writeAllZones );
 	commands.add( CommandIDs::writeZoneToSelected );
 	commands.add( CommandIDs::removeZoneFromSelected );
+	commands.add( CommandIDs::trimZoneStarts );
+	commands.add( CommandIDs::trimZoneEnds );
+	commands.add( CommandIDs::detectPitch );
+	commands.add( CommandIDs::addTransitionZones );
 }
 
 void unc::MainComponent::getCommandInfo( CommandID commandID, ApplicationCommandInfo& result )
@@ -137,6 +141,26 @@ void unc::MainComponent::getCommandInfo( CommandID commandID, ApplicationCommand
 			result.setActive( getSelectedPlayZone().isValid() );
 			break;
 		}
+		case CommandIDs::trimZoneStarts: {
+			result.setInfo( "Trim zone starts", "Move Zone starts of selected Clips past leading silence", CommandCategories::edit, 0 );
+			result.setActive( getSelectedAudioClip() );
+			break;
+		}
+		case CommandIDs::trimZoneEnds: {
+			result.setInfo( "Trim zone ends", "Move Zone ends of selected Clips before trailing silence", CommandCategories::edit, 0 );
+			result.setActive( getSelectedAudioClip() );
+			break;
+		}
+		case CommandIDs::detectPitch: {
+			result.setInfo( "Detect pitch", "Detect root note and pitch curve of selected Clips", CommandCategories::edit, 0 );
+			result.setActive( getSelectedAudioClip() );
+			break;
+		}
+		case CommandIDs::addTransitionZones: {
+			result.setInfo( "Add transition zones", "Add Zones at the legato transition of selected Clips", CommandCategories::edit, 0 );
+			result.setActive( getSelectedAudioClip() );
+			break;
+		}
 		default: break;
 	}
 }
@@ -221,6 +245,22 @@ bool unc::MainComponent::perform( const ApplicationCommandTarget::InvocationInfo
 			}
 			break;
 		}
+		case CommandIDs::trimZoneStarts: {
+			trimSelectedZones( true, false );
+			break;
+		}
+		case CommandIDs::trimZoneEnds: {
+			trimSelectedZones( false, true );
+			break;
+		}
+		case CommandIDs::detectPitch: {
+			detectPitchOfSelected();
+			break;
+		}
+		case CommandIDs::addTransitionZones: {
+			addTransitionZonesToSelected();
+			break;
+		}
 		default: return false;
 	}
 	return true;
@@ -232,6 +272,7 @@ void unc::MainComponent::selectAudioClip( AudioClip* audioClip )
 	selectedPlayZone = AudioPlayZone();
 	selectedRecently = &selectedAudioClip;
 	audioClipEditor.display( audioClip );
+	triggerAsyncUpdate();
 }
 
 void unc::MainComponent::selectAudioPlayZone( const AudioPlayZone& playZone )
@@ -240,11 +281,160 @@ void unc::MainComponent::selectAudioPlayZone( const AudioPlayZone& playZone )
 	selectedRecently = &selectedPlayZone;
 }
 
+void unc::MainComponent::trimSelectedZones( bool trimStarts, bool trimEnds )
+{
+	// scan copies of all clips in parallel in the background, the clips stay editable meanwhile
+	auto clips = getSelectedAudioClipPtrs();
+	auto snapshots = std::make_shared<std::vector<AudioClip::Ptr>>();
+	for( const auto& clip : clips ){
+		snapshots->push_back( clip->createSnapshot() );
+	}
+	auto trimmed = std::make_shared<std::vector<AudioPlayZones>>( clips.size() );
+	const auto token = audioClipList.beginTask();
+	SafePointer<MainComponent> safeThis( this );
+	runInBackground( [ snapshots, trimmed, trimStarts, trimEnds, token ](){
+		aud::parallelFor( ( int )snapshots->size(), [ & ]( int i ){
+			if( token.isCancelled() ){
+				return;
+			}
+			const auto& clip = ( *snapshots )[ ( size_t )i ];
+			const auto audio = clip->getAudio();
+			auto noiseFloor = aud::estimateNoiseFloor( audio );
+			for( const auto& zone : clip->zones ){
+				( *trimmed )[ ( size_t )i ].push_back( trimZone( audio, zone, noiseFloor, trimStarts, trimEnds ) );
+			}
+		}, JobPriority::Background );
+	}, [ safeThis, clips, snapshots, trimmed, trimStarts, token ](){
+		if( !safeThis ){
+			return;
+		}
+		safeThis->audioClipList.endTask();
+		if( token.isCancelled() ){
+			return;
+		}
+		// apply as one undoable transaction, zones changed meanwhile stay as they are
+		getUndoManager()->beginNewTransaction( trimStarts ? "trimZoneStarts" : "trimZoneEnds" );
+		for( size_t i = 0; i < clips.size(); ++i ){
+			const auto& zones = ( *snapshots )[ i ]->zones;
+			for( size_t zoneIdx = 0; zoneIdx < zones.size(); ++zoneIdx ){
+				const auto& zone = ( *trimmed )[ i ][ zoneIdx ];
+				if( !( zone == zones[ zoneIdx ] ) && clips[ i ]->containsZone( zones[ zoneIdx ] ) ){
+					getUndoManager()->perform( new SetPlayZoneCommand( clips[ i ].get(), zones[ zoneIdx ], zone ) );
+				}
+			}
+		}
+	}, JobPriority::Background, token );
+}
+
+void unc::MainComponent::detectPitchOfSelected( std::function<void()> then )
+{
+	// analysis is cached with the clip, clips of equal content and sample rate take it from any analysed one
+	std::set<uint64> analysed;
+	for( int i = 0; i < getAudioClips()->size(); ++i ){
+		auto* clip = getAudioClips()->get( i );
+		if( clip->pitch.isAnalysed() && clip->getAnalysisKey() != 0 ){
+			analysed.insert( clip->getAnalysisKey() );
+		}
+	}
+	std::vector<AudioClip::Ptr> clips;
+	std::vector<AudioClip::Ptr> duplicates;
+	for( const auto& clip : getSelectedAudioClipPtrs() ){
+		if( clip->pitch.isAnalysed() ){
+			continue;
+		}
+		const auto key = clip->getAnalysisKey();
+		if( key != 0 && analysed.count( key ) > 0 ){
+			duplicates.push_back( clip );
+			continue;
+		}
+		if( key != 0 ){
+			analysed.insert( key );
+		}
+		clips.push_back( clip );
+	}
+	// only unique content gets analysed, in the background from copies
+	auto snapshots = std::make_shared<std::vector<AudioClip::Ptr>>();
+	for( const auto& clip : clips ){
+		snapshots->push_back( clip->createSnapshot() );
+	}
+	const auto token = audioClipList.beginTask();
+	SafePointer<MainComponent> safeThis( this );
+	runInBackground( [ snapshots, token ](){
+		aud::parallelFor( ( int )snapshots->size(), [ & ]( int i ){
+			auto& clip = *( *snapshots )[ ( size_t )i ];
+			if( !token.isCancelled() ){
+				clip.pitch = aud::detectPitch( clip.getAudio(), clip.sampleRate );
+			}
+		}, JobPriority::Background );
+	}, [ safeThis, clips, duplicates, snapshots, token, then ](){
+		if( !safeThis ){
+			return;
+		}
+		safeThis->audioClipList.endTask();
+		// clips analysed before a cancel keep their result, duplicates take it from any analysed clip of equal content
+		std::map<uint64, aud::PitchTrack> analysed;
+		for( size_t i = 0; i < clips.size(); ++i ){
+			const auto& pitch = ( *snapshots )[ i ]->pitch;
+			if( pitch.isAnalysed() ){
+				clips[ i ]->pitch = pitch;
+				clips[ i ]->sendChangeMessage();
+				analysed[ clips[ i ]->getAnalysisKey() ] = pitch;
+			}
+		}
+		for( int i = 0; i < safeThis->getAudioClips()->size(); ++i ){
+			auto* clip = safeThis->getAudioClips()->get( i );
+			if( clip->pitch.isAnalysed() && clip->getAnalysisKey() != 0 ){
+				analysed[ clip->getAnalysisKey() ] = clip->pitch;
+			}
+		}
+		for( const auto& clip : duplicates ){
+			const auto match = analysed.find( clip->getAnalysisKey() );
+			if( !clip->pitch.isAnalysed() && match != analysed.end() ){
+				clip->pitch = match->second;
+				clip->sendChangeMessage();
+			}
+		}
+		if( then && !token.isCancelled() ){
+			then();
+		}
+	}, JobPriority::Background, token );
+}
+
+void unc::MainComponent::addTransitionZonesToSelected()
+{
+	// zones follow the pitch, so they are added once it is detected
+	auto clips = getSelectedAudioClipPtrs();
+	detectPitchOfSelected( [ clips ](){
+		getUndoManager()->beginNewTransaction( "addTransitionZones" );
+		for( const auto& clip : clips ){
+			auto transition = aud::findPitchTransition( clip->pitch ).getIntersectionWith( { 0, clip->getTotalNumSamples() } );
+			if( transition.isEmpty() ){
+				continue;
+			}
+			AudioPlayZone zone;
+			zone.start = transition.getStart();
+			zone.length = transition.getLength();
+			zone.mode = AudioPlayMode::Play;
+			zone.name = "Transition";
+			getUndoManager()->perform( new AddPlayZoneCommand( clip.get(), zone ) );
+		}
+	} );
+}
+
 Array<AudioClip*> unc::MainComponent::getSelectedAudioClips() const
 {
 	return audioClipList.getListSelection();
 }
 
+std::vector<AudioClip::Ptr> unc::MainComponent::getSelectedAudioClipPtrs() const
+{
+	std::vector<AudioClip::Ptr> ret;
+	for( auto* clip : getSelectedAudioClips() ){
+		ret.push_back( audioClips.getPtr( audioClips.indexOf( clip ) ) );
+	}
+	return ret;
+}
+
 // MainComponent - persistence
 Result unc::MainComponent::toXml( XmlElement* xml )const
 {
@@ -259,3 +449,36 @@ Result unc::MainComponent::fromXml( XmlElement* xml )
 	}
 	return audioClips.fromXml( clipsXml );
 }
+
+// MainComponent - ChangeListener
+void unc::MainComponent::changeListenerCallback( ChangeBroadcaster* source )
+{
+	if( source == getUndoManager() ){
+		triggerAsyncUpdate();
+	}
+}
+
+// MainComponent - AsyncUpdater
+void unc::MainComponent::handleAsyncUpdate()
+{
+	// render the zones of a copy in the background, a newer request supersedes this one
+	keyMapToken.cancel();
+	keyMapToken = CancelToken();
+	AudioClip::Ptr snapshot;
+	if( selectedAudioClip != nullptr ){
+		snapshot = audioClips.getPtr( audioClips.indexOf( selectedAudioClip ) )->createSnapshot();
+	}
+	auto map = std::make_shared<std::unique_ptr<KeyMap>>();
+	const auto token = keyMapToken;
+	SafePointer<MainComponent> safeThis( this );
+	runInBackground( [ snapshot, map, token ](){
+		if( !token.isCancelled() ){
+			map->reset( createKeyMap( snapshot.get() ) );
+		}
+	}, [ safeThis, map, token ](){
+		// stale maps are dropped with the last reference
+		if( safeThis && !token.isCancelled() && *map != nullptr ){
+			safeThis->zoneSampler.setKeyMap( map->release() );
+		}
+	}, JobPriority::Interactive, token );
+}
@@ -6,6 +6,8 @@
 
 #include "AudioClipEditor.h"
 #include "AudioClipList.h"
+#include "AudioPreview.h"
+#include "AudioSampler.h"
 #include "AudioSettingsDisplay.h"
 #include "Commands.h"
 #include "MainInterface.h"
@@ -16,7 +18,9 @@ namespace unc
 	// MainComponent
 	class MainComponent : public Component,
 		public MainInterface,
-		public ApplicationCommandTarget
+		public ApplicationCommandTarget,
+		private ChangeListener,
+		private AsyncUpdater
 	{
 	public:
 		MainComponent( MenuBarModel* menuBarModel );
@@ -38,12 +42,18 @@ namespace unc
 
 		// modify
 		void selectAudioClip( AudioClip* audioClip )override;
+		void trimSelectedZones( bool trimStarts, bool trimEnds );
+		/// Runs in the background, then calls then on the message thread unless cancelled.
+		void detectPitchOfSelected( std::function<void()> then = nullptr );
+		void addTransitionZonesToSelected();
 		void selectAudioPlayZone( const AudioPlayZone& playZone )override;
 
 		// access
 		AudioClips* getAudioClips(){ return &audioClips; }
 		AudioClip* getSelectedAudioClip() const override{ return selectedAudioClip; }
 		Array<AudioClip*> getSelectedAudioClips() const;
+		/// \returns the selected clips, kept alive by work in the background even if removed meanwhile.
+		std::vector<AudioClip::Ptr> getSelectedAudioClipPtrs() const;
 		AudioPlayZone getSelectedPlayZone() const override{ return selectedPlayZone; }
 
 		// persistence
@@ -51,6 +61,13 @@ namespace unc
 		Result fromXml( XmlElement* xml );
 
 	private:
+		// ChangeListener
+		void changeListenerCallback( ChangeBroadcaster* source )override;
+
+		// AsyncUpdater
+		/// Maps zones of the selected clip to midi notes, the map is built in the background.
+		void handleAsyncUpdate()override;
+
 		MenuBarComponent menuBar;
 		AudioClips audioClips;
 		AudioClip* selectedAudioClip = nullptr;
@@ -59,9 +76,10 @@ namespace unc
 		AudioClipList audioClipList;
 		AudioClipEditor audioClipEditor;
 		aud::AudioSettingsDisplay audioSettingsDisplay;
-		AudioSourcePlayer soundPlayer;
-		std::unique_ptr<MemoryAudioSource> playedSource;
-		std::unique_ptr<AudioBuffer<float>> playedBuffer;
+		aud::PreviewPlayer previewPlayer;
+		ZoneSampler zoneSampler;
+		CancelToken keyMapToken; // of the key map being built
+		aud::CallbackMonitor soundMonitor{ &previewPlayer, &zoneSampler };
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( MainComponent )
 	};
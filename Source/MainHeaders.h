@@ -10,8 +10,26 @@
 #include <memory>
 #include <numeric>
 #include <random>
+#include <set>
 #include <vector>
 
+// deterministic rendering, multiplies and adds are never fused, so every kernel, vector width and target rounds alike
+// off by default, it slows resampling by up to 12% on targets with fused multiply-add, define it to 1 for reproducible renders
+#ifndef UNC_DETERMINISTIC
+ #define UNC_DETERMINISTIC 0
+#endif
+
+/// Pins float evaluation order for the rest of a translation unit, if UNC_DETERMINISTIC.
+#if UNC_DETERMINISTIC && JUCE_CLANG
+ #define UNC_DETERMINISTIC_FLOAT _Pragma( "clang fp contract( off )" )
+#elif UNC_DETERMINISTIC && JUCE_GCC
+ #define UNC_DETERMINISTIC_FLOAT _Pragma( "GCC optimize( \"fp-contract=off\" )" )
+#elif UNC_DETERMINISTIC && JUCE_MSVC
+ #define UNC_DETERMINISTIC_FLOAT __pragma( fp_contract( off ) )
+#else
+ #define UNC_DETERMINISTIC_FLOAT
+#endif
+
 // app
 UndoManager* getUndoManager();
 ApplicationCommandManager* getApplicationCommandManager();
@@ -29,6 +47,9 @@ struct AudioSettings
 	double sampleRate = 0.;
 	int bufferSize = 0;
 	int bitsPerSample = 0;
+
+	/// Hash of decoded audio, see aud::hashBuffer(), 0 if unknown.
+	uint64 contentHash = 0;
 };
 AudioSettings getCurrentAudioSettings();
 
@@ -156,6 +156,7 @@ PopupMenu MainWindow::getMenuForIndex( int topLevelMenuIndex, const String& menu
 		m.addSubMenu( "Open Recent", recent );
 		m.addCommandItem( getApplicationCommandManager(), CommandIDs::saveProject );
 		m.addCommandItem( getApplicationCommandManager(), CommandIDs::saveProjectAs );
+		m.addCommandItem( getApplicationCommandManager(), CommandIDs::exportRenderTrace );
 		m.addSeparator();
 		m.addCommandItem( getApplicationCommandManager(), StandardApplicationCommandIDs::quit );
 	}
@@ -169,6 +170,10 @@ PopupMenu MainWindow::getMenuForIndex( int topLevelMenuIndex, const String& menu
 		m.addCommandItem( getApplicationCommandManager(), CommandIDs::writeAllZones );
 		m.addCommandItem( getApplicationCommandManager(), CommandIDs::writeZoneToSelected );
 		m.addCommandItem( getApplicationCommandManager(), CommandIDs::removeZoneFromSelected );
+		m.addCommandItem( getApplicationCommandManager(), CommandIDs::trimZoneStarts );
+		m.addCommandItem( getApplicationCommandManager(), CommandIDs::trimZoneEnds );
+		m.addCommandItem( getApplicationCommandManager(), CommandIDs::detectPitch );
+		m.addCommandItem( getApplicationCommandManager(), CommandIDs::addTransitionZones );
 		m.addCommandItem( getApplicationCommandManager(), CommandIDs::sortClipsByName );
 		m.addCommandItem( getApplicationCommandManager(), CommandIDs::sortClipsByLength );
 	}
@@ -201,6 +206,7 @@ void MainWindow::getAllCommands( Array<CommandID>& commands )
 	commands.add( CommandIDs::openProject );
 	commands.add( CommandIDs::saveProject );
 	commands.add( CommandIDs::saveProjectAs );
+	commands.add( CommandIDs::exportRenderTrace );
 	commands.add( StandardApplicationCommandIDs::quit );
 }
 
@@ -228,6 +234,10 @@ void MainWindow::getCommandInfo( CommandID commandID, ApplicationCommandInfo& re
 			result.addDefaultKeypress( 's', ModifierKeys::commandModifier | ModifierKeys::shiftModifier );
 			break;
 		}
+		case CommandIDs::exportRenderTrace:{
+			result.setInfo( "Export Render Trace...", "Save Stage Timings of the last Render as Chrome Trace", CommandCategories::file, 0 );
+			break;
+		}
 		case StandardApplicationCommandIDs::quit:{
 			result.setInfo( "Quit", "Quit Application", CommandCategories::file, 0 );
 			result.addDefaultKeypress( 'q', ModifierKeys::commandModifier );
@@ -267,6 +277,13 @@ bool MainWindow::perform( const ApplicationCommandTarget::InvocationInfo& info )
 			}
 			break;
 		}
+		case CommandIDs::exportRenderTrace:{
+			FileChooser chooser( "Export Render Trace", File::getSpecialLocation( File::userDocumentsDirectory ).getChildFile( "render.trace.json" ), "*.json" );
+			if( chooser.browseForFileToSave( true ) && !exportTrace( chooser.getResult() ) ){
+				AlertWindow::showMessageBox( AlertWindow::WarningIcon, "Error", "Could not write " + chooser.getResult().getFullPathName() );
+			}
+			break;
+		}
 		case StandardApplicationCommandIDs::quit: {
 			JUCEApplication::getInstance()->systemRequestedQuit();
 			break;
@@ -1,9 +1,25 @@
 // Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
 #pragma once
 
+// tests run with --test and are left out of release builds unless enabled
+#ifndef UNC_ENABLE_TESTS
+ #define UNC_ENABLE_TESTS JUCE_DEBUG
+#endif
+
+#if UNC_ENABLE_TESTS
+
 // test base libs first
 #include "AudioFunctionsTest.h"
 #include "AudioPlaybackTest.h"
+#include "AudioAnalysisTest.h"
+#include "AudioPitchTest.h"
+#include "AudioOutputTest.h"
+#include "AudioHashTest.h"
+#include "AudioStorageTest.h"
+#include "JobSchedulerTest.h"
 
 // test integrated classes
 #include "AudioClipTest.h"
+#include "AudioRenderTest.h"
+
+#endif
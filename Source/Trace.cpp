@@ -0,0 +1,272 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#include "Trace.h"
+
+using namespace unc;
+
+// allocation counting
+#if UNC_ENABLE_TRACE
+std::atomic<int> numAllocationCounters{ 0 };
+std::atomic<int64> numAllocations{ 0 };
+
+void* operator new( std::size_t size )
+{
+	if( numAllocationCounters.load( std::memory_order_relaxed ) > 0 ){
+		numAllocations.fetch_add( 1, std::memory_order_relaxed );
+	}
+	if( auto* ret = std::malloc( size > 0 ? size : 1 ) ){
+		return ret;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[]( std::size_t size )
+{
+	return operator new( size );
+}
+
+void operator delete( void* ptr ) noexcept
+{
+	std::free( ptr );
+}
+
+void operator delete[]( void* ptr ) noexcept
+{
+	std::free( ptr );
+}
+
+unc::AllocationCounter::AllocationCounter() :
+	start( numAllocations.load() )
+{
+	++numAllocationCounters;
+}
+
+unc::AllocationCounter::~AllocationCounter()
+{
+	--numAllocationCounters;
+}
+
+int64 unc::AllocationCounter::getNumAllocations() const
+{
+	return numAllocations.load() - start;
+}
+#else
+unc::AllocationCounter::AllocationCounter() :
+	start( 0 )
+{}
+
+unc::AllocationCounter::~AllocationCounter()
+{}
+
+int64 unc::AllocationCounter::getNumAllocations() const
+{
+	return 0;
+}
+#endif
+
+// trace buffers
+/// Ring of the latest events of one thread, only the owning thread writes.
+struct TraceBuffer
+{
+	static const uint32 Size = 4096;
+	std::array<TraceEvent, Size> events;
+	std::atomic<uint32> numWritten{ 0 };
+	std::atomic<uint32> firstValid{ 0 };
+	int threadIndex = 0;
+};
+
+/// Owns all buffers, buffers of finished threads are handed to new ones with their events kept.
+struct TraceRegistry
+{
+	TraceBuffer* acquire()
+	{
+		const ScopedLock lock( mutex );
+		if( !unused.empty() ){
+			auto* ret = unused.back();
+			unused.pop_back();
+			return ret;
+		}
+		buffers.emplace_back( new TraceBuffer() );
+		buffers.back()->threadIndex = ( int )buffers.size();
+		return buffers.back().get();
+	}
+
+	void release( TraceBuffer* buffer )
+	{
+		const ScopedLock lock( mutex );
+		unused.push_back( buffer );
+	}
+
+	/// Calls func for every valid event of every buffer.
+	void forEachEvent( const std::function<void( const TraceEvent&, int threadIndex )>& func )
+	{
+		const ScopedLock lock( mutex );
+		for( auto& buffer : buffers ){
+			const auto end = buffer->numWritten.load( std::memory_order_acquire );
+			const auto begin = jmax( buffer->firstValid.load(), end > TraceBuffer::Size ? end - TraceBuffer::Size : 0u );
+			for( auto i = begin; i < end; ++i ){
+				func( buffer->events[ i % TraceBuffer::Size ], buffer->threadIndex );
+			}
+		}
+	}
+
+	CriticalSection mutex;
+	std::vector<std::unique_ptr<TraceBuffer>> buffers;
+	std::vector<TraceBuffer*> unused;
+};
+
+TraceRegistry& getTraceRegistry()
+{
+	static TraceRegistry ret;
+	return ret;
+}
+
+/// Tracing state of the calling thread, the buffer is taken on first use inside a job.
+struct ThreadTrace
+{
+	~ThreadTrace()
+	{
+		if( buffer != nullptr ){
+			getTraceRegistry().release( buffer );
+		}
+	}
+
+	void add( const TraceEvent& event )
+	{
+		if( buffer == nullptr ){
+			buffer = getTraceRegistry().acquire();
+		}
+		const auto n = buffer->numWritten.load( std::memory_order_relaxed );
+		buffer->events[ n % TraceBuffer::Size ] = event;
+		buffer->numWritten.store( n + 1, std::memory_order_release );
+	}
+
+	TraceBuffer* buffer = nullptr;
+	bool isTracing = false;
+	int job = -1;
+};
+
+ThreadTrace& getThreadTrace()
+{
+	thread_local ThreadTrace ret;
+	return ret;
+}
+
+// TraceJob
+unc::TraceJob::TraceJob( int job )
+{
+	auto& trace = getThreadTrace();
+	previousJob = trace.job;
+	wasTracing = trace.isTracing;
+	trace.job = job;
+	trace.isTracing = true;
+}
+
+unc::TraceJob::~TraceJob()
+{
+	auto& trace = getThreadTrace();
+	trace.job = previousJob;
+	trace.isTracing = wasTracing;
+}
+
+// TraceScope
+unc::TraceScope::TraceScope( const char* name )
+{
+	event.name = name;
+	event.start = Time::getHighResolutionTicks();
+}
+
+unc::TraceScope::~TraceScope()
+{
+	auto& trace = getThreadTrace();
+	if( trace.isTracing ){
+		event.end = Time::getHighResolutionTicks();
+		event.job = trace.job;
+		trace.add( event );
+	}
+}
+
+void unc::traceBytes( const char* name, int64 bytes )
+{
+	auto& trace = getThreadTrace();
+	if( trace.isTracing ){
+		TraceEvent event;
+		event.name = name;
+		event.start = event.end = Time::getHighResolutionTicks();
+		event.bytes = bytes;
+		event.job = trace.job;
+		trace.add( event );
+	}
+}
+
+// clearTrace
+void unc::clearTrace()
+{
+	auto& registry = getTraceRegistry();
+	const ScopedLock lock( registry.mutex );
+	for( auto& buffer : registry.buffers ){
+		buffer->firstValid = buffer->numWritten.load();
+	}
+}
+
+// getTraceSummary
+String unc::getTraceSummary()
+{
+	struct Stage
+	{
+		int count = 0;
+		double seconds = 0.;
+		int64 bytes = 0;
+	};
+	std::map<String, Stage> stages;
+	getTraceRegistry().forEachEvent( [ & ]( const TraceEvent& event, int ){
+		auto& stage = stages[ event.name ];
+		stage.seconds += Time::highResolutionTicksToSeconds( event.end - event.start );
+		stage.bytes += event.bytes;
+		if( event.bytes == 0 ){
+			++stage.count;
+		}
+	} );
+	String ret;
+	for( const auto& stage : stages ){
+		ret << stage.first.paddedRight( ' ', 12 ) << " ";
+		if( stage.second.bytes > 0 ){
+			ret << File::descriptionOfSizeInBytes( stage.second.bytes );
+		}
+		else{
+			ret << stage.second.count << "x " << String( stage.second.seconds * 1000., 1 ) << " ms";
+		}
+		ret << newLine;
+	}
+	return ret;
+}
+
+// exportTrace
+bool unc::exportTrace( const File& file )
+{
+	// complete events in microseconds, counters for bytes
+	Array<var> events;
+	const auto ticksPerMicro = Time::getHighResolutionTicksPerSecond() / 1000000.;
+	getTraceRegistry().forEachEvent( [ & ]( const TraceEvent& event, int threadIndex ){
+		DynamicObject::Ptr e( new DynamicObject() );
+		DynamicObject::Ptr args( new DynamicObject() );
+		e->setProperty( "name", event.name );
+		e->setProperty( "pid", 1 );
+		e->setProperty( "tid", threadIndex );
+		e->setProperty( "ts", event.start / ticksPerMicro );
+		if( event.bytes > 0 ){
+			e->setProperty( "ph", "C" );
+			args->setProperty( "bytes", event.bytes );
+		}
+		else{
+			e->setProperty( "ph", "X" );
+			e->setProperty( "dur", ( event.end - event.start ) / ticksPerMicro );
+			args->setProperty( "job", event.job );
+		}
+		e->setProperty( "args", var( args.get() ) );
+		events.add( var( e.get() ) );
+	} );
+	DynamicObject::Ptr ret( new DynamicObject() );
+	ret->setProperty( "traceEvents", events );
+	ret->setProperty( "displayTimeUnit", "ms" );
+	return file.replaceWithText( JSON::toString( var( ret.get() ), true ) );
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 Christoph Mann (christoph.mann@gmail.com)
+#pragma once
+
+#include "MainHeaders.h"
+
+// scoped stage timings, compiled out when disabled
+#ifndef UNC_ENABLE_TRACE
+ #define UNC_ENABLE_TRACE 1
+#endif
+
+namespace unc
+{
+	/// One stage on one thread, times in high resolution ticks.
+	struct TraceEvent
+	{
+		const char* name = nullptr; // string literal
+		int64 start = 0;
+		int64 end = 0;
+		int64 bytes = 0;
+		int job = -1;
+	};
+
+	/// Enables tracing on the calling thread while alive, events inside belong to job.
+	/// Threads outside of a job record nothing, so the audio thread never touches the trace buffers.
+	class TraceJob
+	{
+	public:
+		TraceJob( int job );
+		~TraceJob();
+
+	private:
+		int previousJob;
+		bool wasTracing;
+
+		JUCE_DECLARE_NON_COPYABLE( TraceJob );
+	};
+
+	/// Records the time from construction to destruction into the thread's ring buffer.
+	class TraceScope
+	{
+	public:
+		TraceScope( const char* name );
+		~TraceScope();
+
+	private:
+		TraceEvent event;
+
+		JUCE_DECLARE_NON_COPYABLE( TraceScope );
+	};
+
+	/// Records bytes read or written by a stage, as an instant event.
+	void traceBytes( const char* name, int64 bytes );
+
+	/// Forgets all events recorded so far.
+	void clearTrace();
+
+	/// \returns count, time and bytes per stage since clearTrace(), one line each.
+	String getTraceSummary();
+
+	/// Writes events since clearTrace() as Chrome trace event JSON, readable by chrome://tracing and Perfetto.
+	bool exportTrace( const File& file );
+
+	/// Counts heap allocations of the whole process while alive, counters can nest.
+	/// Allocations of all threads count, ui and audio included, so only quiet processes like benchmarks get exact numbers.
+	/// Counts 0 without UNC_ENABLE_TRACE, which also leaves the global operator new alone.
+	class AllocationCounter
+	{
+	public:
+		AllocationCounter();
+		~AllocationCounter();
+
+		// access
+		int64 getNumAllocations() const;
+
+	private:
+		int64 start;
+
+		JUCE_DECLARE_NON_COPYABLE( AllocationCounter );
+	};
+}
+
+#if UNC_ENABLE_TRACE
+ #define UNC_TRACE_JOB( job ) unc::TraceJob JUCE_JOIN_MACRO( traceJob, __LINE__ )( job )
+ #define UNC_TRACE_SCOPE( name ) unc::TraceScope JUCE_JOIN_MACRO( traceScope, __LINE__ )( name )
+ #define UNC_TRACE_BYTES( name, bytes ) unc::traceBytes( name, bytes )
+#else
+ #define UNC_TRACE_JOB( job )
+ #define UNC_TRACE_SCOPE( name )
+ #define UNC_TRACE_BYTES( name, bytes )
+#endif